@@ -0,0 +1,91 @@
+#include <algorithm>
+#include <cstdio>
+#include <iomanip>
+#include <thread>
+#include <unistd.h>
+
+#include "benchmark.hh"
+#include "evalcache.hh"
+
+using namespace std;
+
+static const uint64_t max_iterations = 1000000000;
+
+void BenchmarkRunner::run( const string & name, const function< void( BenchmarkState & ) > & benchmark )
+{
+  if ( name.find( _filter ) == string::npos ) {
+    return;
+  }
+
+  uint64_t iterations = 1;
+  while ( true ) {
+    BenchmarkState state( iterations );
+    benchmark( state );
+
+    if ( state.real_seconds >= _min_time or iterations >= max_iterations ) {
+      _results.push_back( Result { name, iterations,
+	    state.real_seconds * 1e9 / iterations,
+	    state.cpu_seconds * 1e9 / iterations,
+	    state.counters } );
+      fprintf( stderr, "%-60s %12.0f ns %12.0f ns %10lu\n", name.c_str(),
+	       _results.back().real_time, _results.back().cpu_time,
+	       static_cast< unsigned long >( iterations ) );
+      return;
+    }
+
+    /* aim a little past min_time, growing at most tenfold at a time */
+    const double multiplier = _min_time * 1.4 / max( state.real_seconds, 1e-9 );
+    iterations = min( max_iterations,
+		      max( iterations + 1, uint64_t( iterations * min( multiplier, 10.0 ) ) ) );
+  }
+}
+
+static string json_string( const string & s )
+{
+  string ret = "\"";
+  for ( const char c : s ) {
+    if ( c == '"' or c == '\\' ) {
+      ret += '\\';
+    }
+    ret += c;
+  }
+  return ret + "\"";
+}
+
+void BenchmarkRunner::write_json( ostream & out ) const
+{
+  char host[ 256 ] = "";
+  gethostname( host, sizeof( host ) - 1 );
+
+  const time_t now = time( nullptr );
+  char date[ 64 ];
+  strftime( date, sizeof( date ), "%Y-%m-%dT%H:%M:%S%z", localtime( &now ) );
+
+  out << setprecision( 17 );
+  out << "{\n  \"context\": {\n"
+      << "    \"date\": " << json_string( date ) << ",\n"
+      << "    \"host_name\": " << json_string( host ) << ",\n"
+      << "    \"num_cpus\": " << thread::hardware_concurrency() << ",\n"
+#ifdef NDEBUG
+      << "    \"library_build_type\": \"release\",\n"
+#else
+      << "    \"library_build_type\": \"debug\",\n"
+#endif
+      << "    \"simulator_version\": " << EvalCache::simulator_version << "\n"
+      << "  },\n  \"benchmarks\": [";
+
+  for ( unsigned int i = 0; i < _results.size(); i++ ) {
+    const Result & x = _results[ i ];
+    out << (i ? "," : "") << "\n    {\n"
+	<< "      \"name\": " << json_string( x.name ) << ",\n"
+	<< "      \"iterations\": " << x.iterations << ",\n"
+	<< "      \"real_time\": " << x.real_time << ",\n"
+	<< "      \"cpu_time\": " << x.cpu_time << ",\n";
+    for ( const auto & counter : x.counters ) {
+      out << "      " << json_string( counter.first ) << ": " << counter.second << ",\n";
+    }
+    out << "      \"time_unit\": \"ns\"\n    }";
+  }
+
+  out << "\n  ]\n}\n";
+}
@@ -0,0 +1,95 @@
+#ifndef BENCHMARK_HH
+#define BENCHMARK_HH
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/* A small harness in the style of Google Benchmark. A benchmark is a
+   function that sets up what it needs and then runs its timed loop
+   while state.keep_running(); only the loop is timed. The runner
+   repeats each benchmark with more iterations until the loop takes
+   at least min_time seconds, and reports per-iteration times as JSON
+   so that results can be compared from one release to the next. */
+class BenchmarkState
+{
+private:
+  uint64_t _iterations;
+  uint64_t _remaining;
+  bool _started;
+
+  std::chrono::steady_clock::time_point _real_start;
+  std::clock_t _cpu_start;
+
+public:
+  double real_seconds, cpu_seconds;
+
+  /* reported alongside the times, e.g. a score to catch changes in results */
+  std::map< std::string, double > counters;
+
+  BenchmarkState( const uint64_t iterations )
+    : _iterations( iterations ), _remaining( iterations ), _started( false ),
+      _real_start(), _cpu_start( 0 ),
+      real_seconds( 0 ), cpu_seconds( 0 ), counters()
+  {}
+
+  bool keep_running( void )
+  {
+    if ( not _started ) {
+      _started = true;
+      _real_start = std::chrono::steady_clock::now();
+      _cpu_start = std::clock();
+    }
+
+    if ( _remaining ) {
+      _remaining--;
+      return true;
+    }
+
+    real_seconds = std::chrono::duration< double >( std::chrono::steady_clock::now() - _real_start ).count();
+    cpu_seconds = double( std::clock() - _cpu_start ) / CLOCKS_PER_SEC;
+    return false;
+  }
+
+  uint64_t iterations( void ) const { return _iterations; }
+};
+
+/* keep the compiler from optimizing away a result */
+template <typename T>
+inline void do_not_optimize( const T & value )
+{
+  asm volatile( "" : : "g"( &value ) : "memory" );
+}
+
+class BenchmarkRunner
+{
+private:
+  struct Result
+  {
+    std::string name;
+    uint64_t iterations;
+    double real_time, cpu_time; /* nanoseconds per iteration */
+    std::map< std::string, double > counters;
+  };
+
+  double _min_time;
+  std::string _filter;
+  std::vector< Result > _results;
+
+public:
+  /* runs only the benchmarks whose names contain filter */
+  BenchmarkRunner( const double min_time, const std::string & filter )
+    : _min_time( min_time ), _filter( filter ), _results()
+  {}
+
+  void run( const std::string & name, const std::function< void( BenchmarkState & ) > & benchmark );
+
+  void write_json( std::ostream & out ) const;
+};
+
+#endif
@@ -0,0 +1,99 @@
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "benchmark.hh"
+#include "evaluator.hh"
+
+using namespace std;
+
+/* a fixed grid, so that timings are comparable between releases */
+static vector< NetConfig > config_grid( void )
+{
+  vector< NetConfig > ret;
+  for ( const double link_ppt : { 0.3, 1.0, 3.0 } ) {
+    for ( const double num_senders : { 2, 8 } ) {
+      ret.push_back( NetConfig().set_link_ppt( link_ppt ).set_delay( 100 ).set_num_senders( num_senders )
+		     .set_on_duration( 5000 ).set_off_duration( 5000 ) );
+    }
+  }
+  return ret;
+}
+
+static WhiskerTree load_tree( const string & filename )
+{
+  int fd = open( filename.c_str(), O_RDONLY );
+  if ( fd < 0 ) {
+    perror( "open" );
+    exit( 1 );
+  }
+
+  RemyBuffers::WhiskerTree tree;
+  if ( !tree.ParseFromFileDescriptor( fd ) ) {
+    fprintf( stderr, "Could not parse %s.\n", filename.c_str() );
+    exit( 1 );
+  }
+
+  if ( close( fd ) < 0 ) {
+    perror( "close" );
+    exit( 1 );
+  }
+
+  return WhiskerTree( tree );
+}
+
+int main( int argc, char *argv[] )
+{
+  vector< string > filenames;
+  unsigned int ticks = 100000;
+  double min_time = 0.5;
+  string filter;
+
+  for ( int i = 1; i < argc; i++ ) {
+    string arg( argv[ i ] );
+    if ( arg.substr( 0, 6 ) == "ticks=" ) {
+      ticks = atoi( arg.substr( 6 ).c_str() );
+    } else if ( arg.substr( 0, 9 ) == "min_time=" ) {
+      min_time = atof( arg.substr( 9 ).c_str() );
+    } else if ( arg.substr( 0, 7 ) == "filter=" ) {
+      filter = arg.substr( 7 );
+    } else {
+      filenames.push_back( arg );
+    }
+  }
+
+  if ( filenames.empty() ) {
+    fprintf( stderr, "Usage: %s [ticks=TICKS] [min_time=SECONDS] [filter=SUBSTRING] TREE.dna...\n", argv[ 0 ] );
+    exit( 1 );
+  }
+
+  BenchmarkRunner runner( min_time, filter );
+
+  for ( const auto & filename : filenames ) {
+    WhiskerTree whiskers = load_tree( filename );
+    const string tree_name = filename.substr( filename.rfind( '/' ) + 1 );
+
+    for ( const auto & config : config_grid() ) {
+      ostringstream name;
+      name << "Evaluator::score/" << tree_name << "/link:" << config.link_ppt
+	   << "/senders:" << config.num_senders << "/ticks:" << ticks;
+
+      runner.run( name.str(), [&] ( BenchmarkState & state ) {
+	  double score = 0;
+	  while ( state.keep_running() ) {
+	    score = Evaluator< WhiskerTree >::score( whiskers, 1, { config }, false, ticks ).score;
+	  }
+	  state.counters[ "score" ] = score;
+	} );
+    }
+  }
+
+  runner.write_json( cout );
+
+  return 0;
+}
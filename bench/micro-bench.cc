@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "benchmark.hh"
+#include "compiledtree.hh"
+#include "link.hh"
+#include "memory.hh"
+#include "rat.hh"
+#include "receiver.hh"
+#include "sendergang.cc"
+#include "link-templates.cc"
+#include "rat-templates.cc"
+
+using namespace std;
+
+/* swallows packets at the end of a chain */
+struct Sink
+{
+  unsigned int packets = 0;
+  void accept( const Packet &, const double & ) noexcept { packets++; }
+};
+
+static void bench_use_action( BenchmarkState & state, const WhiskerTree & tree )
+{
+  const CompiledWhiskerTree compiled( tree );
+  UsageLedger usage( compiled.num_leaves(), false );
+
+  /* congestion signals in roughly the ranges seen in simulation */
+  const double scale[ Memory::datasize ] = { 200, 200, 4, 200, 300, 300 };
+  PRNG prng( 1 );
+  vector< Memory > queries( 1024 );
+  for ( auto & x : queries ) {
+    for ( unsigned int i = 0; i < Memory::datasize; i++ ) {
+      x.mutable_field( i ) = scale[ i ] * prng.uniform() + (i == 2 ? 1 : 0);
+    }
+  }
+
+  unsigned int i = 0;
+  while ( state.keep_running() ) {
+    do_not_optimize( compiled.use_action( queries[ i++ & 1023 ], usage, false ) );
+  }
+}
+
+static void bench_memory_packets_received( BenchmarkState & state )
+{
+  Memory memory;
+  vector< Packet > packets( 4, Packet( 0, 0, 0, 0 ) );
+
+  double tickno = 0;
+  int seq_num = 0;
+  while ( state.keep_running() ) {
+    for ( auto & x : packets ) {
+      x.seq_num = seq_num++;
+      x.tick_sent = tickno;
+      x.tick_received = tickno + 100 + (seq_num & 7);
+      tickno += 1;
+    }
+    memory.packets_received( PacketSpan( packets.data(), packets.size() ), 0, seq_num - 1 );
+    do_not_optimize( memory );
+  }
+}
+
+static void bench_link( BenchmarkState & state )
+{
+  /* keep a standing queue of 64 packets behind the one being served */
+  Link link( 1.0, 1000 );
+  Sink sink;
+  double tickno = 0;
+  int seq_num = 0;
+  for ( ; seq_num < 65; seq_num++ ) {
+    link.accept( Packet( 0, 0, tickno, seq_num ), tickno );
+  }
+
+  while ( state.keep_running() ) {
+    link.accept( Packet( 0, 0, tickno, seq_num++ ), tickno );
+    tickno = link.next_event_time( tickno );
+    link.tick( sink, tickno );
+  }
+
+  do_not_optimize( sink.packets );
+}
+
+static void bench_delay( BenchmarkState & state )
+{
+  /* one packet in flight for each tick of delay */
+  Delay delay( 100 );
+  Sink sink;
+  double tickno = 0;
+  int seq_num = 0;
+  for ( ; seq_num < 100; seq_num++, tickno++ ) {
+    delay.accept( Packet( 0, 0, tickno, seq_num ), tickno );
+  }
+
+  while ( state.keep_running() ) {
+    tickno = delay.next_event_time( tickno );
+    delay.tick( sink, tickno );
+    delay.accept( Packet( 0, 0, tickno, seq_num++ ), tickno );
+  }
+
+  do_not_optimize( sink.packets );
+}
+
+static void bench_sender_gang( BenchmarkState & state, const WhiskerTree & tree, const unsigned int num_senders )
+{
+  /* the gang drives a link and a path back to the receiver, as in Network,
+     so that the senders see ACKs; one iteration is one event */
+  const CompiledWhiskerTree compiled( tree );
+  UsageLedger usage( compiled.num_leaves(), false );
+  PRNG prng( 1 );
+  SenderGang< Rat, TimeSwitchedSender< Rat > > gang( 1000, 1000, num_senders, Rat( compiled, usage ), prng );
+  Link link( 1.0, 1000 );
+  Delay delay( 100 );
+  Receiver rec( num_senders );
+
+  double tickno = 0;
+  while ( state.keep_running() ) {
+    tickno = min( min( gang.next_event_time( tickno ), link.next_event_time( tickno ) ),
+		  min( delay.next_event_time( tickno ), rec.next_event_time( tickno ) ) );
+    gang.tick( link, rec, tickno );
+    link.tick( delay, tickno );
+    delay.tick( rec, tickno );
+  }
+}
+
+int main( int argc, char *argv[] )
+{
+  WhiskerTree whiskers;
+  string tree_name = "default";
+  double min_time = 0.5;
+  string filter;
+
+  for ( int i = 1; i < argc; i++ ) {
+    string arg( argv[ i ] );
+    if ( arg.substr( 0, 5 ) == "tree=" ) {
+      string filename( arg.substr( 5 ) );
+      int fd = open( filename.c_str(), O_RDONLY );
+      if ( fd < 0 ) {
+	perror( "open" );
+	exit( 1 );
+      }
+
+      RemyBuffers::WhiskerTree tree;
+      if ( !tree.ParseFromFileDescriptor( fd ) ) {
+	fprintf( stderr, "Could not parse %s.\n", filename.c_str() );
+	exit( 1 );
+      }
+      whiskers = WhiskerTree( tree );
+
+      if ( close( fd ) < 0 ) {
+	perror( "close" );
+	exit( 1 );
+      }
+
+      tree_name = filename.substr( filename.rfind( '/' ) + 1 );
+    } else if ( arg.substr( 0, 9 ) == "min_time=" ) {
+      min_time = atof( arg.substr( 9 ).c_str() );
+    } else if ( arg.substr( 0, 7 ) == "filter=" ) {
+      filter = arg.substr( 7 );
+    } else {
+      fprintf( stderr, "Usage: %s [tree=FILENAME] [min_time=SECONDS] [filter=SUBSTRING]\n", argv[ 0 ] );
+      exit( 1 );
+    }
+  }
+
+  BenchmarkRunner runner( min_time, filter );
+
+  runner.run( "CompiledWhiskerTree::use_action/" + tree_name,
+	      [&] ( BenchmarkState & state ) { bench_use_action( state, whiskers ); } );
+  runner.run( "Memory::packets_received/4", bench_memory_packets_received );
+  runner.run( "Link::accept_tick", bench_link );
+  runner.run( "Delay::accept_tick", bench_delay );
+  for ( const unsigned int num_senders : { 10, 100, 1000, 10000 } ) {
+    runner.run( "SenderGang::tick/" + tree_name + "/senders:" + to_string( num_senders ),
+		[&] ( BenchmarkState & state ) { bench_sender_gang( state, whiskers, num_senders ); } );
+  }
+
+  runner.write_json( cout );
+
+  return 0;
+}
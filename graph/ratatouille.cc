@@ -194,11 +194,15 @@ int main( int argc, char *argv[] )
     m /= 2;
   }
 
+  const CompiledFinTree compiled_fins( fins );
+  const CompiledWhiskerTree compiled_whiskers( whiskers );
+  UsageLedger usage( is_poisson ? compiled_fins.num_leaves() : compiled_whiskers.num_leaves(), false );
+
   if ( is_poisson ) {
-    Network< FishGang, AimdGang > network( Fish( fins, fish_prng_seed, false ), Aimd(), prng, configuration );
+    Network< FishGang, AimdGang > network( Fish( compiled_fins, usage, fish_prng_seed, false ), Aimd(), prng, configuration );
     simulate<Network< FishGang, AimdGang >>(network, graph, fader);
   } else {
-    Network< RatGang, AimdGang > network( Rat( whiskers, false ), Aimd(), prng, configuration );
+    Network< RatGang, AimdGang > network( Rat( compiled_whiskers, usage, false ), Aimd(), prng, configuration );
     simulate<Network< RatGang, AimdGang >>(network, graph, fader);
   }
 
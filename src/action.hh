@@ -33,9 +33,9 @@ public:
     return ret;
   }
 
-  void use( void ) const { _domain.use(); }
-  void reset_count( void ) const { _domain.reset_count(); }
   unsigned int count( void ) const { return _domain.count(); }
+  void set_count( const unsigned int count ) { _domain.set_count( count ); }
+  void set_medians( const std::vector< MedianSketch > & medians ) { _domain.set_medians( medians ); }
 
   const unsigned int & generation( void ) const { return _generation; }
   const MemoryRange & domain( void ) const { return _domain; }
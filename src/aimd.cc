@@ -19,7 +19,7 @@ Aimd::Aimd()
 {
 }
 
-void Aimd::packets_received( const vector< Packet > & packets ) {
+void Aimd::packets_received( const PacketSpan & packets ) {
   bool loss_detected = false;
   for ( auto & packet : packets ) {
     loss_detected = ( not loss_detected ) ?
@@ -28,7 +28,7 @@ void Aimd::packets_received( const vector< Packet > & packets ) {
     _largest_ack = max( _largest_ack, packet.seq_num );
 
     _packets_received++;
-    if ( packet.flow_id != _flow_id ) {
+    if ( not packet.of_flow( _flow_id ) ) {
       /* This was from the previous flow, ignore it for congestion control */
       continue;
     }
@@ -29,7 +29,7 @@ private:
 public:
   Aimd();
 
-  void packets_received( const std::vector< Packet > & packets );
+  void packets_received( const PacketSpan & packets );
   void reset( const double & tickno ); /* start new flow */
 
   template <class NextHop>
@@ -1,5 +1,7 @@
 #include <cassert>
+#include <cmath>
 #include <limits>
+#include <numeric>
 #include <boost/accumulators/accumulators.hpp>
 #include <boost/accumulators/statistics.hpp>
 #include <boost/accumulators/statistics/tail_quantile.hpp>
@@ -12,6 +14,156 @@ using namespace std;
 typedef accumulator_set< double, stats< tag::tail_quantile <boost::accumulators::right > > >
   accumulator_t_right;
 
+template <>
+BreederState< WhiskerTree >::BreederState( const CheckpointBuffers::BreederState & dna )
+  : input_tree( dna.input_whiskers() ),
+    generation( dna.generation() ),
+    improved(),
+    action(),
+    prng_seed( dna.prng_seed() ),
+    keep_seed( dna.keep_seed() ),
+    score_to_beat( dna.score_to_beat() ),
+    eval_cache()
+{
+  for ( const auto & x : dna.improved_whiskers() ) {
+    improved.emplace_back( x );
+  }
+
+  if ( dna.has_whisker() ) {
+    action.emplace_back( dna.whisker() );
+  }
+
+  for ( const auto & x : dna.eval_cache() ) {
+    eval_cache.emplace_back( Whisker( x.whisker() ), x.score() );
+  }
+}
+
+template <>
+BreederState< FinTree >::BreederState( const CheckpointBuffers::BreederState & dna )
+  : input_tree( dna.input_fins() ),
+    generation( dna.generation() ),
+    improved(),
+    action(),
+    prng_seed( dna.prng_seed() ),
+    keep_seed( dna.keep_seed() ),
+    score_to_beat( dna.score_to_beat() ),
+    eval_cache()
+{
+  for ( const auto & x : dna.improved_fins() ) {
+    improved.emplace_back( x );
+  }
+
+  if ( dna.has_fin() ) {
+    action.emplace_back( dna.fin() );
+  }
+
+  for ( const auto & x : dna.eval_cache() ) {
+    eval_cache.emplace_back( Fin( x.fin() ), x.score() );
+  }
+}
+
+template <>
+CheckpointBuffers::BreederState BreederState< WhiskerTree >::DNA( void ) const
+{
+  CheckpointBuffers::BreederState ret;
+  ret.mutable_input_whiskers()->CopyFrom( input_tree.DNA() );
+  ret.set_generation( generation );
+
+  for ( const auto & x : improved ) {
+    ret.add_improved_whiskers()->CopyFrom( x.DNA() );
+  }
+
+  if ( keep_seed ) {
+    ret.set_prng_seed( prng_seed );
+    ret.set_keep_seed( true );
+  }
+
+  if ( not action.empty() ) {
+    ret.mutable_whisker()->CopyFrom( action.front().DNA() );
+    ret.set_prng_seed( prng_seed );
+    ret.set_score_to_beat( score_to_beat );
+
+    for ( const auto & x : eval_cache ) {
+      CheckpointBuffers::ActionScore *entry = ret.add_eval_cache();
+      entry->mutable_whisker()->CopyFrom( x.first.DNA() );
+      entry->set_score( x.second );
+    }
+  }
+
+  return ret;
+}
+
+template <>
+CheckpointBuffers::BreederState BreederState< FinTree >::DNA( void ) const
+{
+  CheckpointBuffers::BreederState ret;
+  ret.mutable_input_fins()->CopyFrom( input_tree.DNA() );
+  ret.set_generation( generation );
+
+  for ( const auto & x : improved ) {
+    ret.add_improved_fins()->CopyFrom( x.DNA() );
+  }
+
+  if ( keep_seed ) {
+    ret.set_prng_seed( prng_seed );
+    ret.set_keep_seed( true );
+  }
+
+  if ( not action.empty() ) {
+    ret.mutable_fin()->CopyFrom( action.front().DNA() );
+    ret.set_prng_seed( prng_seed );
+    ret.set_score_to_beat( score_to_beat );
+
+    for ( const auto & x : eval_cache ) {
+      CheckpointBuffers::ActionScore *entry = ret.add_eval_cache();
+      entry->mutable_fin()->CopyFrom( x.first.DNA() );
+      entry->set_score( x.second );
+    }
+  }
+
+  return ret;
+}
+
+template <typename T>
+void BreederState< T >::restore_generations( T & tree ) const
+{
+  /* every action is at the generation reached, or one past it once improved */
+  tree.promote( generation );
+  for ( const auto & x : improved ) {
+    A action( x );
+    action.demote( generation + 1 );
+    const auto result __attribute((unused)) = tree.replace( action );
+    assert( result );
+  }
+}
+
+template <typename T>
+typename Evaluator< T >::Outcome Breeder< T >::improve( T & tree )
+{
+  /* back up the original tree */
+  /* this is to ensure we don't regress */
+  BreederState< T > state;
+  state.input_tree = tree;
+
+  /* evaluate the actions we have */
+  tree.reset_generation();
+
+  return resume( tree, state );
+}
+
+template <typename T>
+unsigned int Breeder< T >::careful_seed( void )
+{
+  if ( not _options.fixed_careful_seed ) {
+    return global_PRNG()();
+  }
+
+  if ( _careful_seed.empty() ) {
+    _careful_seed.push_back( global_PRNG()() );
+  }
+  return _careful_seed.front();
+}
+
 template <typename T>
 void Breeder< T >::apply_best_split( T & tree, const unsigned int generation ) const
 {
@@ -41,69 +193,126 @@ void Breeder< T >::apply_best_split( T & tree, const unsigned int generation ) c
 template <typename T, typename A>
 ActionImprover< T, A >::ActionImprover( const Evaluator< T > & s_evaluator,
 				  const T & tree,
-				  const double score_to_beat)
+				  const double score_to_beat,
+				  const RacingSchedule & racing )
   : eval_( s_evaluator ),
     tree_( tree ),
+    racing_( racing ),
     score_to_beat_( score_to_beat )
 {}
 
 template <typename T, typename A>
-void ActionImprover< T, A >::evaluate_replacements(const vector<A> &replacements,
-    vector< pair< const A &, future< pair< bool, double > > > > &scores,
-    const double carefulness ) 
+vector< pair< bool, double > > ActionImprover< T, A >::evaluate_replacements( const vector< A > &replacements,
+									      const double carefulness )
 {
+  /* the new evaluations all replace the same leaf, so they run as one batch */
+  vector< A > unknown;
+  for ( const auto & test_replacement : replacements ) {
+    if ( eval_cache_.find( test_replacement ) == eval_cache_.end() ) {
+      unknown.push_back( test_replacement );
+    }
+  }
+
+  vector< double > unknown_scores;
+  if ( not unknown.empty() ) {
+    for ( const auto & x : eval_.score_replacements( tree_, unknown, carefulness, eval_.num_configs() ) ) {
+      unknown_scores.push_back( accumulate( x.begin(), x.end(), 0.0 ) );
+    }
+  }
+
+  vector< pair< bool, double > > scores;
+  unsigned int next_unknown = 0;
   for ( const auto & test_replacement : replacements ) {
     if ( eval_cache_.find( test_replacement ) == eval_cache_.end() ) {
-      /* need to fire off a new thread to evaluate */
-      scores.emplace_back( test_replacement,
-                           async( launch::async, [] ( const Evaluator< T > & e,
-                                                      const A & r,
-                                                      const T & tree,
-                                                      const double carefulness ) {
-                                    T replaced_tree( tree );
-                                    const bool found_replacement __attribute((unused)) = replaced_tree.replace( r );
-                                    assert( found_replacement );
-                                    return make_pair( true, e.score( replaced_tree, false, carefulness ).score ); },
-                                  eval_, test_replacement, tree_, carefulness ) );
+      scores.emplace_back( true, unknown_scores.at( next_unknown++ ) );
     } else {
       /* we already know the score */
-      scores.emplace_back( test_replacement,
-        async( launch::deferred, [] ( const double value ) {
-               return make_pair( false, value ); }, eval_cache_.at( test_replacement ) ) );
+      scores.emplace_back( false, eval_cache_.at( test_replacement ) );
     }
-  } 
+  }
+
+  return scores;
+}
+
+/* estimate of the full score from a sample of the configs, and its
+   standard error (zero when every config was run) */
+static pair< double, double > estimate_score( const vector< double > & config_scores,
+					      const unsigned int total_configs )
+{
+  const unsigned int n = config_scores.size();
+
+  double sum = 0;
+  for ( const auto & x : config_scores ) {
+    sum += x;
+  }
+
+  if ( n < 2 or n == total_configs ) {
+    return make_pair( sum * (double( total_configs ) / n), 0.0 );
+  }
+
+  const double mean = sum / n;
+  double squares = 0;
+  for ( const auto & x : config_scores ) {
+    squares += (x - mean) * (x - mean);
+  }
+
+  /* sampled without replacement from a finite set of configs */
+  const double variance_of_mean = squares / (n - 1) / n * (total_configs - n) / (total_configs - 1);
+
+  return make_pair( mean * total_configs, sqrt( variance_of_mean ) * total_configs );
 }
 
 template <typename T, typename A>
-vector<A> ActionImprover< T, A >::early_bail_out( const vector< A > &replacements,
-        const double carefulness, const double quantile_to_keep )
-{  
-  vector< pair< const A &, future< pair< bool, double > > > > scores;
-  evaluate_replacements( replacements, scores, carefulness );
-  
+vector<A> ActionImprover< T, A >::race( const vector< A > &replacements,
+					const RacingStage & stage )
+{
+  if ( replacements.empty() ) {
+    return replacements;
+  }
+
+  const unsigned int total_configs = eval_.num_configs();
+  const unsigned int num_configs = std::min( total_configs,
+					std::max( 1u, (unsigned int) ceil( stage.config_fraction * total_configs ) ) );
+
+  /* run the new evaluations as one batch; a known full score is its own estimate */
+  vector< A > unknown;
+  for ( const auto & test_replacement : replacements ) {
+    if ( eval_cache_.find( test_replacement ) == eval_cache_.end() ) {
+      unknown.push_back( test_replacement );
+    }
+  }
+
+  vector< vector< double > > unknown_scores;
+  if ( not unknown.empty() ) {
+    unknown_scores = eval_.score_replacements( tree_, unknown, stage.carefulness, num_configs );
+  }
+
   accumulator_t_right acc(
-     tag::tail< boost::accumulators::right >::cache_size = scores.size() );
-  vector<double> raw_scores;
-  for ( auto & x : scores ) {
-    const double score( x.second.get().second );
-    acc( score );
-    raw_scores.push_back( score );
-  }
-  
+     tag::tail< boost::accumulators::right >::cache_size = replacements.size() );
+  vector< pair< double, double > > raw_estimates;
+  unsigned int next_unknown = 0;
+  for ( const auto & test_replacement : replacements ) {
+    const auto estimate( eval_cache_.find( test_replacement ) == eval_cache_.end()
+			 ? estimate_score( unknown_scores.at( next_unknown++ ), total_configs )
+			 : make_pair( eval_cache_.at( test_replacement ), 0.0 ) );
+    acc( estimate.first );
+    raw_estimates.push_back( estimate );
+  }
+
   /* Set the lower bound to be MAX_PERCENT_ERROR worse than the current best score */
   double lower_bound = std::min( score_to_beat_ * (1 + MAX_PERCENT_ERROR), 
         score_to_beat_ * (1 - MAX_PERCENT_ERROR) );
   /* Get the score at given quantile */
-  double quantile_bound = quantile( acc, quantile_probability = 1 - quantile_to_keep );
+  double quantile_bound = quantile( acc, quantile_probability = 1 - stage.keep_fraction );
   double cutoff = std::max( lower_bound, quantile_bound );
 
-  /* Discard replacements below threshold */
+  /* Discard replacements that are clearly below threshold */
   vector<A> top_replacements;
-  for ( uint i = 0; i < scores.size(); i ++ ) {
-    const A & replacement( scores.at( i ).first );
-    const double score( raw_scores.at( i ) );
-    if ( score >= cutoff ) {
-      top_replacements.push_back( replacement );
+  for ( uint i = 0; i < replacements.size(); i ++ ) {
+    const double score( raw_estimates.at( i ).first );
+    const double error( raw_estimates.at( i ).second );
+    if ( score + racing_.confidence * error >= cutoff ) {
+      top_replacements.push_back( replacements.at( i ) );
     }
   }
   return top_replacements;
@@ -113,19 +322,20 @@ template <typename T, typename A>
 double ActionImprover< T, A >::improve( A & action_to_improve )
 {
   auto replacements = get_replacements( action_to_improve );
-  vector< pair< const A &, future< pair< bool, double > > > > scores;
 
-  /* Run for 10% simulation time to get estimates for the final score 
-     and discard bad performing ones early on. */
-  vector<A> top_replacements = early_bail_out( replacements, 0.1, 0.5 );
+  /* Race the candidates on shortened runs over some of the configs,
+     discarding bad performing ones early on. */
+  vector<A> top_replacements = replacements;
+  for ( const auto & stage : racing_.stages ) {
+    top_replacements = race( top_replacements, stage );
+  }
 
   /* find best replacement */
-  evaluate_replacements( top_replacements, scores, 1 );
-  for ( auto & x : scores ) {
-     const A & replacement( x.first );
-     const auto outcome( x.second.get() );
-     const bool was_new_evaluation( outcome.first );
-     const double score( outcome.second );
+  const auto scores( evaluate_replacements( top_replacements, 1 ) );
+  for ( unsigned int i = 0; i < top_replacements.size(); i++ ) {
+     const A & replacement( top_replacements.at( i ) );
+     const bool was_new_evaluation( scores.at( i ).first );
+     const double score( scores.at( i ).second );
 
      /* should we cache this result? */
      if ( was_new_evaluation ) {
@@ -143,7 +353,21 @@ double ActionImprover< T, A >::improve( A & action_to_improve )
   return score_to_beat_;
 }
 
+template <typename T, typename A>
+vector< pair< A, double > > ActionImprover< T, A >::eval_cache( void ) const
+{
+  return vector< pair< A, double > >( eval_cache_.begin(), eval_cache_.end() );
+}
+
+template <typename T, typename A>
+void ActionImprover< T, A >::restore_eval_cache( const vector< pair< A, double > > & cache )
+{
+  eval_cache_.insert( cache.begin(), cache.end() );
+}
+
 template class ActionImprover< WhiskerTree, Whisker >;
 template class ActionImprover< FinTree, Fin >;
+template struct BreederState< FinTree >;
+template struct BreederState< WhiskerTree >;
 template class Breeder< FinTree >;
 template class Breeder< WhiskerTree >;
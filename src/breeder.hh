@@ -3,15 +3,53 @@
 
 #include <unordered_map>
 #include <boost/functional/hash.hpp>
-#include <future>
+#include <functional>
 #include <vector>
 
 #include "configrange.hh"
+#include "racingschedule.hh"
 #include "evaluator.hh"
+#include "checkpoint.pb.h"
 
 struct BreederOptions
 {
   ConfigRange config_range = ConfigRange();
+  RacingSchedule racing = RacingSchedule();
+
+  /* end every improve() by comparing with one seed drawn for the whole
+     run, rather than a fresh one each time: the tree a round started
+     from is then already scored, but every round is judged on the same
+     networks, so their acceptances are no longer independent */
+  bool fixed_careful_seed = false;
+};
+
+/* How far a call to Breeder::improve() has got: the tree it started
+   from, the generation it has reached and the actions already improved
+   at it and, while an action is being improved, that action, the seed
+   of the Evaluator scoring it, the score to beat and every replacement
+   score known so far. */
+template <typename T>
+struct BreederState
+{
+  typedef typename T::ActionType A;
+
+  T input_tree {};
+  unsigned int generation = 0;
+  std::vector< A > improved {};
+
+  std::vector< A > action {}; /* empty between actions */
+  unsigned int prng_seed = 0;
+  bool keep_seed = false; /* the tree has only been promoted since prng_seed scored it */
+  double score_to_beat = 0;
+  std::vector< std::pair< A, double > > eval_cache {};
+
+  BreederState() {}
+  BreederState( const CheckpointBuffers::BreederState & dna );
+  CheckpointBuffers::BreederState DNA( void ) const;
+
+  /* a tree's DNA doesn't record its actions' generations, so bring a
+     tree read back from a checkpoint to the generations it had */
+  void restore_generations( T & tree ) const;
 };
 
 template <typename T, typename A>
@@ -23,25 +61,30 @@ protected:
 
   T tree_;
 
+  const RacingSchedule racing_;
+
   std::unordered_map< A, double, boost::hash< A > > eval_cache_ {};
 
   double score_to_beat_;
 
   virtual std::vector< A > get_replacements( A & action_to_improve ) = 0;
 
-  void evaluate_replacements(const std::vector< A > &replacements,
-    std::vector< std::pair< const A &, std::future< std::pair< bool, double > > > > &scores,
-    const double carefulness);
+  /* full-length score of each replacement, and whether it was newly evaluated */
+  std::vector< std::pair< bool, double > > evaluate_replacements( const std::vector< A > &replacements,
+								  const double carefulness );
 
-  std::vector< A > early_bail_out(const std::vector< A > &replacements,
-        const double carefulness, const double quantile_to_keep);
+  std::vector< A > race( const std::vector< A > &replacements, const RacingStage & stage );
 
 public:
   ActionImprover( const Evaluator<  T > & evaluator, const T & tree, 
-                   const double score_to_beat );
+                   const double score_to_beat, const RacingSchedule & racing );
   virtual ~ActionImprover() {};
 
   double improve( A & action_to_improve );
+
+  /* full-length scores of the replacements tried so far */
+  std::vector< std::pair< A, double > > eval_cache( void ) const;
+  void restore_eval_cache( const std::vector< std::pair< A, double > > & cache );
 };
 
 template <typename T>
@@ -50,13 +93,41 @@ class Breeder
 protected:
   BreederOptions _options;
 
+  std::function< void( const T & tree, const BreederState< T > & state ) > _checkpoint;
+
+  /* with fixed_careful_seed, the seed every improve() ends by comparing
+     its trees with, drawn once */
+  std::vector< unsigned int > _careful_seed {}; /* empty until drawn */
+
   void apply_best_split( T & tree, const unsigned int generation ) const;
 
+  unsigned int careful_seed( void );
+
+  void checkpoint( const T & tree, const BreederState< T > & state ) const
+  {
+    if ( _checkpoint ) {
+      _checkpoint( tree, state );
+    }
+  }
+
 public:
-  Breeder( const BreederOptions & s_options ) : _options( s_options ) {};
+  Breeder( const BreederOptions & s_options ) : _options( s_options ), _checkpoint() {};
   virtual ~Breeder() {};
 
-  virtual typename Evaluator< T >::Outcome improve( T & whiskers ) = 0;
+  typename Evaluator< T >::Outcome improve( T & tree );
+
+  /* carry on with an improve() that was interrupted in the given state */
+  virtual typename Evaluator< T >::Outcome resume( T & tree, BreederState< T > & state ) = 0;
+
+  /* called after every improvement step with what resume() needs */
+  void set_checkpoint( const std::function< void( const T & tree, const BreederState< T > & state ) > & checkpoint )
+  {
+    _checkpoint = checkpoint;
+  }
+
+  /* for checkpoints: empty until the first improve() draws it */
+  const std::vector< unsigned int > & saved_careful_seed( void ) const { return _careful_seed; }
+  void restore_careful_seed( const std::vector< unsigned int > & seed ) { _careful_seed = seed; }
 };
 
 #endif
@@ -0,0 +1,63 @@
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#include "checkpoint.hh"
+
+using namespace std;
+
+void write_atomically( const google::protobuf::Message & message, const string & filename )
+{
+  const string temporary( filename + ".tmp" );
+
+  int fd = open( temporary.c_str(), O_WRONLY | O_TRUNC | O_CREAT, S_IRUSR | S_IWUSR );
+  if ( fd < 0 ) {
+    perror( "open" );
+    exit( 1 );
+  }
+
+  if ( not message.SerializeToFileDescriptor( fd ) ) {
+    fprintf( stderr, "Could not serialize %s.\n", filename.c_str() );
+    exit( 1 );
+  }
+
+  if ( fsync( fd ) < 0 ) {
+    perror( "fsync" );
+    exit( 1 );
+  }
+
+  if ( close( fd ) < 0 ) {
+    perror( "close" );
+    exit( 1 );
+  }
+
+  if ( rename( temporary.c_str(), filename.c_str() ) < 0 ) {
+    perror( "rename" );
+    exit( 1 );
+  }
+}
+
+CheckpointBuffers::Checkpoint read_checkpoint( const string & filename )
+{
+  int fd = open( filename.c_str(), O_RDONLY );
+  if ( fd < 0 ) {
+    perror( "open" );
+    exit( 1 );
+  }
+
+  CheckpointBuffers::Checkpoint checkpoint;
+  if ( !checkpoint.ParseFromFileDescriptor( fd ) ) {
+    fprintf( stderr, "Could not parse %s.\n", filename.c_str() );
+    exit( 1 );
+  }
+
+  if ( close( fd ) < 0 ) {
+    perror( "close" );
+    exit( 1 );
+  }
+
+  return checkpoint;
+}
@@ -0,0 +1,17 @@
+#ifndef CHECKPOINT_HH
+#define CHECKPOINT_HH
+
+#include <string>
+
+#include "checkpoint.pb.h"
+
+/* Checkpoints let a remy or remy-poisson run that was killed carry on
+   exactly where it stopped (see resume= and checkpoint=). */
+
+/* replace the file with a serialized message, so that a crash at any
+   point leaves either the old contents or the new */
+void write_atomically( const google::protobuf::Message & message, const std::string & filename );
+
+CheckpointBuffers::Checkpoint read_checkpoint( const std::string & filename );
+
+#endif
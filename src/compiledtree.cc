@@ -0,0 +1,176 @@
+#include <cassert>
+
+#include "compiledtree.hh"
+
+using namespace std;
+
+template <class TreeType, class ActionType>
+CompiledTree< TreeType, ActionType >::Node::Node( const MemoryRange & domain )
+  : lower(),
+    upper(),
+    active_axes( 0 ),
+    first_child( 0 ),
+    num_children( 0 ),
+    leaf( 0 ),
+    action( nullptr )
+{
+  for ( unsigned int i = 0; i < Memory::datasize; i++ ) {
+    lower[ i ] = domain.lower().field( i );
+    upper[ i ] = domain.upper().field( i );
+  }
+
+  for ( auto & i : domain.active_axis() ) {
+    active_axes |= 1 << i;
+  }
+}
+
+template <class TreeType, class ActionType>
+CompiledTree< TreeType, ActionType >::CompiledTree( const TreeType & tree,
+						    const ActionType * replacement )
+  : _nodes(),
+    _num_leaves( 0 ),
+    _replacement( replacement ),
+    _replaced( false ),
+    _replaced_node( 0 )
+{
+  _nodes.emplace_back( tree._domain );
+  add_children( 0, tree );
+
+  assert( _replaced or not _replacement );
+}
+
+template <class TreeType, class ActionType>
+void CompiledTree< TreeType, ActionType >::add_children( const unsigned int index, const TreeType & tree )
+{
+  if ( tree.is_leaf() ) {
+    const ActionType & action = tree._leaf.front();
+
+    _nodes[ index ].leaf = _num_leaves++;
+    _nodes[ index ].action = &action;
+
+    if ( _replacement and action.domain() == _replacement->domain() ) {
+      assert( not _replaced );
+      _nodes[ index ].action = _replacement;
+      _replaced = true;
+      _replaced_node = index;
+    }
+
+    return;
+  }
+
+  const unsigned int first_child = _nodes.size();
+  _nodes[ index ].first_child = first_child;
+  _nodes[ index ].num_children = tree._children.size();
+
+  for ( const auto & x : tree._children ) {
+    _nodes.emplace_back( x._domain );
+  }
+
+  for ( unsigned int i = 0; i < tree._children.size(); i++ ) {
+    add_children( first_child + i, tree._children[ i ] );
+  }
+}
+
+template <class TreeType, class ActionType>
+void CompiledTree< TreeType, ActionType >::replace( const ActionType & replacement )
+{
+  assert( _replaced );
+  assert( replacement.domain() == _replacement->domain() );
+
+  _replacement = &replacement;
+  _nodes[ _replaced_node ].action = _replacement;
+}
+
+template <class TreeType, class ActionType>
+unsigned int CompiledTree< TreeType, ActionType >::replaced_leaf( void ) const
+{
+  assert( _replaced );
+  return _nodes[ _replaced_node ].leaf;
+}
+
+template <class TreeType, class ActionType>
+bool CompiledTree< TreeType, ActionType >::contains( const Node & node, const Memory::DataType * query )
+{
+  /* same test as MemoryRange::contains, without early exits */
+  bool ret = true;
+  for ( unsigned int i = 0; i < Memory::datasize; i++ ) {
+    const bool inside = (query[ i ] >= node.lower[ i ]) & (query[ i ] < node.upper[ i ]);
+    const bool active = (node.active_axes >> i) & 1;
+    ret &= inside | !active;
+  }
+  return ret;
+}
+
+template <class TreeType, class ActionType>
+const typename CompiledTree< TreeType, ActionType >::Node * CompiledTree< TreeType, ActionType >::leaf( const Memory & _memory ) const
+{
+  Memory::DataType query[ Memory::datasize ];
+  for ( unsigned int i = 0; i < Memory::datasize; i++ ) {
+    query[ i ] = _memory.field( i );
+  }
+
+  const Node * node = &_nodes.front();
+  if ( !contains( *node, query ) ) {
+    return nullptr;
+  }
+
+  /* need to descend */
+  while ( node->num_children ) {
+    const Node * child = &_nodes[ node->first_child ];
+    const Node * const last_child = child + node->num_children;
+
+    while ( child != last_child and !contains( *child, query ) ) {
+      child++;
+    }
+
+    if ( child == last_child ) {
+      assert( false );
+      return nullptr;
+    }
+
+    node = child;
+  }
+
+  return node;
+}
+
+template <class TreeType, class ActionType>
+const ActionType & CompiledTree< TreeType, ActionType >::use_action( const Memory & _memory,
+								     UsageLedger & usage,
+								     const bool track ) const
+{
+  const Node * ret( leaf( _memory ) );
+
+  if ( !ret ) {
+    fprintf( stderr, "ERROR: No action found for %s\n", _memory.str().c_str() );
+    exit( 1 );
+  }
+
+  usage.use( ret->leaf );
+
+  if ( track ) {
+    usage.track( ret->leaf, _memory, ret->action->domain().active_axis() );
+  }
+
+  return *ret->action;
+}
+
+template <class TreeType, class ActionType>
+ContentHash::Key CompiledTree< TreeType, ActionType >::fingerprint( void ) const
+{
+  ContentHash hash;
+  for ( const auto & node : _nodes ) {
+    hash.add( node.lower, sizeof( node.lower ) );
+    hash.add( node.upper, sizeof( node.upper ) );
+    hash.add_value( node.active_axes );
+    hash.add_value( node.num_children );
+
+    if ( node.action ) {
+      hash.add( node.action->DNA().SerializeAsString() );
+    }
+  }
+  return hash.key();
+}
+
+template class CompiledTree< WhiskerTree, Whisker >;
+template class CompiledTree< FinTree, Fin >;
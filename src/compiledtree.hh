@@ -0,0 +1,77 @@
+#ifndef COMPILEDTREE_HH
+#define COMPILEDTREE_HH
+
+#include <vector>
+
+#include "whiskertree.hh"
+#include "fintree.hh"
+#include "usageledger.hh"
+#include "contenthash.hh"
+
+/* Read-only, flattened copy of a WhiskerTree or FinTree for fast
+   lookups during simulation. Leaves point back at the actions of the
+   original tree, which must outlive this. One leaf's action can be
+   swapped for a replacement, so that candidate actions can be scored
+   without copying the whole tree. */
+template <class TreeType, class ActionType>
+class CompiledTree
+{
+private:
+  struct Node
+  {
+    Memory::DataType lower[ Memory::datasize ];
+    Memory::DataType upper[ Memory::datasize ];
+    unsigned int active_axes; /* bitmask */
+
+    /* children are stored contiguously; a leaf has none */
+    unsigned int first_child;
+    unsigned int num_children;
+
+    unsigned int leaf; /* depth-first leaf number, for the UsageLedger */
+    const ActionType * action;
+
+    Node( const MemoryRange & domain );
+  };
+
+  std::vector< Node > _nodes; /* root first */
+  unsigned int _num_leaves;
+
+  const ActionType * _replacement;
+  bool _replaced;
+  unsigned int _replaced_node;
+
+  void add_children( const unsigned int index, const TreeType & tree );
+
+  static bool contains( const Node & node, const Memory::DataType * query );
+
+  const Node * leaf( const Memory & _memory ) const;
+
+public:
+  CompiledTree( const TreeType & tree, const ActionType * replacement = nullptr );
+
+  CompiledTree( const CompiledTree & ) = delete;
+  CompiledTree & operator=( const CompiledTree & ) = delete;
+
+  unsigned int num_leaves( void ) const { return _num_leaves; }
+
+  /* swap in another replacement for the same leaf (matched by domain);
+     lookups see it at once, so running simulations must not be ticked
+     concurrently */
+  void replace( const ActionType & replacement );
+
+  /* the leaf number of the replaced action */
+  unsigned int replaced_leaf( void ) const;
+
+  const ActionType & use_action( const Memory & _memory, UsageLedger & usage, const bool track ) const;
+
+  /* hash of everything that affects lookups (but not e.g. generations) */
+  ContentHash::Key fingerprint( void ) const;
+
+  /* bytes taken up by this copy (but not by the actions it points to) */
+  size_t footprint( void ) const { return sizeof( *this ) + _nodes.capacity() * sizeof( Node ); }
+};
+
+typedef CompiledTree< WhiskerTree, Whisker > CompiledWhiskerTree;
+typedef CompiledTree< FinTree, Fin > CompiledFinTree;
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef CONTENTHASH_HH
+#define CONTENTHASH_HH
+
+#include <cstdint>
+#include <string>
+
+/* 128-bit hash of a stream of bytes, stable across runs and builds,
+   used to name simulation results by their inputs. Not cryptographic. */
+class ContentHash
+{
+public:
+  struct Key
+  {
+    uint64_t a;
+    uint64_t b;
+
+    bool operator==( const Key & other ) const { return a == other.a and b == other.b; }
+  };
+
+  /* for unordered containers; the key is already well mixed */
+  struct KeyHash
+  {
+    size_t operator()( const Key & key ) const { return key.a; }
+  };
+
+private:
+  uint64_t _a, _b;
+
+public:
+  ContentHash() : _a( 0xcbf29ce484222325ULL ), _b( 0x84222325cbf29ce4ULL ) {}
+
+  ContentHash & add( const void * data, const size_t length )
+  {
+    const unsigned char * bytes = static_cast< const unsigned char * >( data );
+    for ( size_t i = 0; i < length; i++ ) {
+      _a = (_a ^ bytes[ i ]) * 0x100000001b3ULL;
+      _b = (_b ^ bytes[ i ]) * 0x9e3779b97f4a7c15ULL;
+    }
+    return *this;
+  }
+
+  ContentHash & add( const std::string & s )
+  {
+    const uint64_t length = s.size();
+    add( &length, sizeof( length ) );
+    return add( s.data(), s.size() );
+  }
+
+  template <typename T>
+  ContentHash & add_value( const T & x ) { return add( &x, sizeof( x ) ); }
+
+  Key key( void ) const
+  {
+    /* finish with a full-avalanche mix of each half */
+    auto mix = [] ( uint64_t x ) {
+      x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+      return x ^ (x >> 31);
+    };
+    return Key { mix( _a ), mix( _b ^ _a ) };
+  }
+};
+
+#endif
@@ -1,20 +1,33 @@
 #ifndef DELAY_HH
 #define DELAY_HH
 
-#include <deque>
-#include <tuple>
 #include <cassert>
 #include <limits>
 #include <cstdio>
+#include <vector>
 
 #include "packet.hh"
+#include "ringbuffer.hh"
 
 class Delay
 {
 private:
-  std::deque< std::tuple< double, Packet, bool > > _queue;
-  /* queue members: release time, contents, whether release time was adjusted after-the-fact */
+  struct DelayedPacket
+  {
+    double release_time;
+    Packet packet;
+
+    DelayedPacket( const double s_release_time, const Packet & s_packet )
+      : release_time( s_release_time ), packet( s_packet ) {}
+  };
+
+  RingBuffer< DelayedPacket > _queue;
   double _delay;
+
+  /* the release times of the first _adjusted packets were moved earlier
+     after they were sent (every packet in flight is shifted together,
+     so these are always the oldest ones) */
+  unsigned int _adjusted;
   bool _adjusted_packets_are_in_flight;
 
   void fixup_adjusted_packets( const double tickno )
@@ -25,28 +38,29 @@ private:
 
     /* for packets that were in-flight when delay was reduced,
        make sure that they get released asap */
-    for ( auto & p : _queue ) {
-      if ( std::get< 2 >( p ) and std::get< 0 >( p ) < tickno ) {
-	std::get< 0 >( p ) = tickno;
-	std::get< 2 >( p ) = false;
+    for ( unsigned int i = 0; i < _adjusted; i++ ) {
+      DelayedPacket & p = _queue.at( i );
+      if ( p.release_time >= tickno ) {
+	break;
       }
+      p.release_time = tickno;
     }
 
     _adjusted_packets_are_in_flight = false;
   }
 
 public:
-  Delay( const double s_delay ) : _queue(), _delay( s_delay ), _adjusted_packets_are_in_flight( false ) {}
+  Delay( const double s_delay ) : _queue(), _delay( s_delay ), _adjusted( 0 ), _adjusted_packets_are_in_flight( false ) {}
  
   void accept( const Packet & p, const double & tickno ) noexcept
   {
     /* Make sure that we haven't reordered packets when delay was adjusted
        on packets already in-flight */
     if ( not _queue.empty() ) {
-      assert( tickno + _delay >= std::get< 0 >( _queue.front() ) );
+      assert( tickno + _delay >= _queue.front().release_time );
     }
 
-    _queue.emplace_back( tickno + _delay, p, false );
+    _queue.emplace_back( tickno + _delay, p );
   }
 
   template <class NextHop>
@@ -54,10 +68,13 @@ public:
   {
     fixup_adjusted_packets( tickno );
 
-    while ( (!_queue.empty()) && (std::get< 0 >( _queue.front() ) <= tickno) ) {
-      assert( std::get< 0 >( _queue.front() ) == tickno );
-      next.accept( std::get< 1 >( _queue.front() ), tickno );
+    while ( (!_queue.empty()) && (_queue.front().release_time <= tickno) ) {
+      assert( _queue.front().release_time == tickno );
+      next.accept( _queue.front().packet, tickno );
       _queue.pop_front();
+      if ( _adjusted ) {
+	_adjusted--;
+      }
     }
   }
 
@@ -67,24 +84,28 @@ public:
       return std::numeric_limits<double>::max();
     }
 
-    if ( std::get< 0 >( _queue.front() ) < tickno
-	 and std::get< 2 >( _queue.front() ) ) {
+    if ( _queue.front().release_time < tickno
+	 and _adjusted ) {
       return tickno; /* packet's delay was adjusted to be earlier than present time,
 			so just release asap */
     }
 
-    assert( std::get< 0 >( _queue.front() ) >= tickno );
+    assert( _queue.front().release_time >= tickno );
 
-    return std::get< 0 >( _queue.front() );
+    return _queue.front().release_time;
   }
 
   bool empty( void ) const { return _queue.empty(); }
+  size_t size( void ) const { return _queue.size(); }
+
+  void reserve( const unsigned int n ) { _queue.reserve( n ); }
+  size_t footprint( void ) const { return _queue.footprint(); }
 
   std::vector<unsigned int> packets_in_flight( const unsigned int num_senders ) const
   {
     std::vector<unsigned int> ret( num_senders );
     for ( const auto & x : _queue ) {
-      ret.at( std::get<1>( x ).src )++;
+      ret.at( x.packet.src )++;
     }
     return ret;
   }
@@ -96,12 +117,12 @@ public:
 
     /* Step 2: Adjust existing packets-in-flight */
     for ( auto & p : _queue ) {
-      std::get< 0 >( p ) += delay_difference;
+      p.release_time += delay_difference;
+    }
 
-      if ( delay_difference < 0 ) {
-	std::get< 2 >( p ) = true;
-	_adjusted_packets_are_in_flight = true;
-      }
+    if ( delay_difference < 0 and not _queue.empty() ) {
+      _adjusted = _queue.size();
+      _adjusted_packets_are_in_flight = true;
     }
 
     /* Step 3: Change delay that will be applied to future packets */
@@ -0,0 +1,193 @@
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+#include "dispatcher.hh"
+#include "messagesocket.hh"
+#include "threadpool.hh"
+
+using namespace std;
+
+Dispatcher::Dispatcher( const vector< string > & workers, const unsigned int timeout )
+  : _workers( workers ),
+    _timeout( timeout ),
+    _mutex(),
+    _job_ready(),
+    _jobs(),
+    _connected( 0 ),
+    _failure(),
+    _stopping( false ),
+    _threads()
+{
+  if ( workers.empty() ) {
+    return;
+  }
+
+  /* a worker that goes away shows up as a failed write, not a signal */
+  signal( SIGPIPE, SIG_IGN );
+
+  for ( const auto & x : _workers ) {
+    _threads.emplace_back( [this, x] () { serve( x ); } );
+  }
+}
+
+Dispatcher::~Dispatcher()
+{
+  {
+    unique_lock< mutex > lock( _mutex );
+    _stopping = true;
+  }
+  _job_ready.notify_all();
+
+  for ( auto & x : _threads ) {
+    x.join();
+  }
+}
+
+future< AnswerBuffers::Outcome > Dispatcher::submit( const ProblemBuffers::Problem & problem )
+{
+  unique_ptr< Job > job( new Job { problem, promise< AnswerBuffers::Outcome >(), 0,
+				   chrono::steady_clock::now() } );
+  future< AnswerBuffers::Outcome > ret = job->outcome.get_future();
+
+  {
+    unique_lock< mutex > lock( _mutex );
+    if ( not _failure.empty() ) {
+      fail( *job, _failure );
+      return ret;
+    }
+    _jobs.push_back( move( job ) );
+  }
+  _job_ready.notify_all();
+
+  return ret;
+}
+
+void Dispatcher::fail( Job & job, const string & reason )
+{
+  job.outcome.set_exception( make_exception_ptr( DispatchFailure( reason ) ) );
+  global_thread_pool().notify_waiters();
+}
+
+void Dispatcher::give_up( const string & reason )
+{
+  _failure = reason;
+  for ( auto & x : _jobs ) {
+    fail( *x, reason );
+  }
+  _jobs.clear();
+}
+
+void Dispatcher::serve( const string & address )
+{
+  int fd = -1;
+  unsigned int backoff = 1; /* seconds; reset by an answer */
+  bool unreachable = false;
+
+  while ( 1 ) {
+    if ( fd < 0 ) {
+      fd = connect_socket( address );
+      if ( fd < 0 ) {
+	if ( not unreachable ) {
+	  fprintf( stderr, "Could not connect to worker %s; will keep trying.\n", address.c_str() );
+	  unreachable = true;
+	}
+
+	unique_lock< mutex > lock( _mutex );
+	if ( _connected == 0 ) {
+	  /* with no worker to be reached, nothing would ever answer */
+	  const auto now = chrono::steady_clock::now();
+	  const bool expired = any_of( _jobs.begin(), _jobs.end(), [&] ( const unique_ptr< Job > & x ) {
+	      return now - x->queued > chrono::seconds( _timeout ); } );
+	  if ( expired ) {
+	    give_up( "no worker could be reached for " + to_string( _timeout ) + " seconds" );
+	  }
+	}
+
+	if ( _job_ready.wait_for( lock, chrono::seconds( backoff ), [&] () { return _stopping; } ) ) {
+	  break;
+	}
+	backoff = min( 2 * backoff, 32u );
+	continue;
+      }
+      unreachable = false;
+
+      unique_lock< mutex > lock( _mutex );
+      _connected++;
+    }
+
+    unique_ptr< Job > job;
+    {
+      unique_lock< mutex > lock( _mutex );
+      _job_ready.wait( lock, [&] () { return _stopping or not _jobs.empty(); } );
+      if ( _stopping ) {
+	break;
+      }
+      job = move( _jobs.front() );
+      _jobs.pop_front();
+    }
+
+    AnswerBuffers::Outcome outcome;
+    if ( send_message( fd, job->problem ) and receive_message( fd, outcome, _timeout * 1000 ) ) {
+      job->outcome.set_value( outcome );
+      /* the answer didn't come from a pool task, so waiters need a nudge */
+      global_thread_pool().notify_waiters();
+      backoff = 1;
+      continue;
+    }
+
+    /* drop the connection (a late answer would be out of step) and
+       give the problem to whoever is free */
+    fprintf( stderr, "Lost connection to worker %s, or it took over %u seconds.\n",
+	     address.c_str(), _timeout );
+    close( fd );
+    fd = -1;
+
+    {
+      unique_lock< mutex > lock( _mutex );
+      _connected--;
+      if ( ++job->attempts >= max_attempts ) {
+	give_up( "a problem failed to be evaluated " + to_string( job->attempts ) + " times" );
+	fail( *job, _failure );
+      } else {
+	job->queued = chrono::steady_clock::now();
+	_jobs.push_front( move( job ) );
+      }
+    }
+    /* all, since connections waiting out a backoff share the condition */
+    _job_ready.notify_all();
+
+    /* let the other connections have the first go at it */
+    unique_lock< mutex > lock( _mutex );
+    if ( _job_ready.wait_for( lock, chrono::seconds( backoff ), [&] () { return _stopping; } ) ) {
+      break;
+    }
+    backoff = min( 2 * backoff, 32u );
+  }
+
+  if ( fd >= 0 ) {
+    close( fd );
+  }
+}
+
+static vector< string > global_dispatcher_workers;
+static unsigned int global_dispatcher_timeout = Dispatcher::default_timeout;
+
+void set_global_dispatcher_workers( const vector< string > & workers )
+{
+  global_dispatcher_workers = workers;
+}
+
+void set_global_dispatcher_timeout( const unsigned int timeout )
+{
+  global_dispatcher_timeout = timeout;
+}
+
+Dispatcher & global_dispatcher( void )
+{
+  static Dispatcher dispatcher( global_dispatcher_workers, global_dispatcher_timeout );
+  return dispatcher;
+}
@@ -0,0 +1,93 @@
+#ifndef DISPATCHER_HH
+#define DISPATCHER_HH
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "problem.pb.h"
+#include "answer.pb.h"
+
+/* Farms scoring Problems out to remy-worker processes (see
+   messagesocket.hh for addresses). Each address gets one connection,
+   served by its own thread, so listing a worker twice sends it two
+   problems at a time. A problem whose connection fails, or whose
+   worker hasn't answered within the timeout, is put back in the queue
+   for any connection to retry. Once a problem has failed max_attempts
+   times, or has waited longer than the timeout while no worker could
+   be reached, the Dispatcher gives up: that problem, every problem
+   queued and every one submitted later is answered with a
+   DispatchFailure instead. */
+class Dispatcher
+{
+public:
+  /* tries per problem before it fails */
+  static const unsigned int max_attempts = 4;
+
+  static const unsigned int default_timeout = 600; /* seconds */
+
+private:
+  struct Job
+  {
+    ProblemBuffers::Problem problem;
+    std::promise< AnswerBuffers::Outcome > outcome;
+    unsigned int attempts;
+    std::chrono::steady_clock::time_point queued;
+  };
+
+  std::vector< std::string > _workers;
+  const unsigned int _timeout;
+
+  std::mutex _mutex;
+  std::condition_variable _job_ready;
+  std::deque< std::unique_ptr< Job > > _jobs;
+  unsigned int _connected; /* connections up */
+  std::string _failure; /* why it gave up, if it has */
+  bool _stopping;
+
+  std::vector< std::thread > _threads;
+
+  void serve( const std::string & address );
+
+  static void fail( Job & job, const std::string & reason );
+
+  /* with _mutex held */
+  void give_up( const std::string & reason );
+
+public:
+  /* with no workers, nothing is dispatched */
+  Dispatcher( const std::vector< std::string > & workers,
+	      const unsigned int timeout = default_timeout );
+  ~Dispatcher();
+
+  Dispatcher( const Dispatcher & ) = delete;
+  Dispatcher & operator=( const Dispatcher & ) = delete;
+
+  bool enabled( void ) const { return not _workers.empty(); }
+  unsigned int size( void ) const { return _workers.size(); }
+  unsigned int timeout( void ) const { return _timeout; }
+
+  std::future< AnswerBuffers::Outcome > submit( const ProblemBuffers::Problem & problem );
+};
+
+/* what the future of a Problem the Dispatcher gave up on throws */
+class DispatchFailure : public std::runtime_error
+{
+public:
+  explicit DispatchFailure( const std::string & reason ) : std::runtime_error( reason ) {}
+};
+
+/* must be called before the first use of global_dispatcher() */
+extern void set_global_dispatcher_workers( const std::vector< std::string > & workers );
+extern void set_global_dispatcher_timeout( const unsigned int timeout );
+
+extern Dispatcher & global_dispatcher( void );
+
+#endif
@@ -0,0 +1,265 @@
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "evalcache.hh"
+
+using namespace std;
+
+struct EvalCache::Header
+{
+  char magic[ 8 ];
+  uint32_t format_version;
+  uint32_t simulator_version;
+  uint64_t capacity; /* entries; a power of two */
+  uint64_t size;
+};
+
+struct EvalCache::Entry
+{
+  ContentHash::Key key; /* all zero if the slot is free */
+  double score;
+};
+
+static const char cache_magic[ 8 ] = "remyevc";
+static const uint32_t cache_format_version = 1;
+static const uint64_t initial_capacity = 1 << 16;
+
+size_t EvalCache::file_length( const uint64_t capacity )
+{
+  return sizeof( Header ) + capacity * sizeof( Entry );
+}
+
+static int open_locked( const string & filename, const int flags )
+{
+  int fd = open( filename.c_str(), O_RDWR | O_CREAT | flags, S_IRUSR | S_IWUSR );
+  if ( fd < 0 ) {
+    perror( "open" );
+    exit( 1 );
+  }
+
+  if ( flock( fd, LOCK_EX | LOCK_NB ) < 0 ) {
+    fprintf( stderr, "Evaluation cache %s is in use by another process.\n", filename.c_str() );
+    exit( 1 );
+  }
+
+  return fd;
+}
+
+/* the all-zero key marks a free slot */
+static ContentHash::Key stored_key( ContentHash::Key key )
+{
+  if ( key.a == 0 and key.b == 0 ) {
+    key.b = 1;
+  }
+  return key;
+}
+
+EvalCache::EvalCache( const string & filename )
+  : _filename( filename ),
+    _fd( -1 ),
+    _header( nullptr ),
+    _mapped_length( 0 ),
+    _mutex()
+{
+  if ( filename.empty() ) {
+    return;
+  }
+
+  int fd = open_locked( filename, 0 );
+
+  struct stat st;
+  if ( fstat( fd, &st ) < 0 ) {
+    perror( "fstat" );
+    exit( 1 );
+  }
+
+  /* keep what's there if it was written by this simulator */
+  Header existing = Header();
+  bool valid = false;
+  if ( size_t( st.st_size ) >= sizeof( existing )
+       and pread( fd, &existing, sizeof( existing ), 0 ) == ssize_t( sizeof( existing ) ) ) {
+    valid = !memcmp( existing.magic, cache_magic, sizeof( cache_magic ) )
+      and existing.format_version == cache_format_version
+      and existing.simulator_version == simulator_version
+      and existing.capacity > 0
+      and (existing.capacity & (existing.capacity - 1)) == 0
+      and size_t( st.st_size ) == file_length( existing.capacity );
+
+    if ( not valid ) {
+      fprintf( stderr, "Discarding stale evaluation cache %s.\n", filename.c_str() );
+    }
+  }
+
+  map( fd, valid ? existing.capacity : initial_capacity, not valid );
+}
+
+EvalCache::~EvalCache()
+{
+  unmap();
+}
+
+void EvalCache::map( const int fd, const uint64_t capacity, const bool initialize )
+{
+  const size_t length = file_length( capacity );
+
+  if ( initialize ) {
+    if ( ftruncate( fd, 0 ) < 0 or ftruncate( fd, length ) < 0 ) {
+      perror( "ftruncate" );
+      exit( 1 );
+    }
+  }
+
+  void * mapping = mmap( nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+  if ( mapping == MAP_FAILED ) {
+    perror( "mmap" );
+    exit( 1 );
+  }
+
+  _fd = fd;
+  _header = static_cast< Header * >( mapping );
+  _mapped_length = length;
+
+  if ( initialize ) {
+    memcpy( _header->magic, cache_magic, sizeof( cache_magic ) );
+    _header->format_version = cache_format_version;
+    _header->simulator_version = simulator_version;
+    _header->capacity = capacity;
+    _header->size = 0;
+  }
+}
+
+void EvalCache::unmap( void )
+{
+  if ( not _header ) {
+    return;
+  }
+
+  if ( munmap( _header, _mapped_length ) < 0 ) {
+    perror( "munmap" );
+    exit( 1 );
+  }
+
+  if ( close( _fd ) < 0 ) {
+    perror( "close" );
+    exit( 1 );
+  }
+
+  _header = nullptr;
+  _fd = -1;
+}
+
+EvalCache::Entry * EvalCache::slot( const ContentHash::Key & key ) const
+{
+  Entry * entries = reinterpret_cast< Entry * >( _header + 1 );
+  const uint64_t mask = _header->capacity - 1;
+
+  /* linear probing; the table is never full */
+  for ( uint64_t i = key.a & mask; ; i = (i + 1) & mask ) {
+    Entry & entry = entries[ i ];
+    if ( entry.key == key or (entry.key.a == 0 and entry.key.b == 0) ) {
+      return &entry;
+    }
+  }
+}
+
+void EvalCache::grow( void )
+{
+  /* build the bigger table beside the old one, then swap it in */
+  const string temporary( _filename + ".tmp" );
+  const uint64_t old_capacity = _header->capacity;
+  Header * const old_header = _header;
+  const size_t old_length = _mapped_length;
+  const int old_fd = _fd;
+
+  map( open_locked( temporary, O_TRUNC ), old_capacity * 2, true );
+
+  const Entry * old_entries = reinterpret_cast< const Entry * >( old_header + 1 );
+  for ( uint64_t i = 0; i < old_capacity; i++ ) {
+    const Entry & entry = old_entries[ i ];
+    if ( entry.key.a != 0 or entry.key.b != 0 ) {
+      *slot( entry.key ) = entry;
+      _header->size++;
+    }
+  }
+
+  if ( msync( _header, _mapped_length, MS_SYNC ) < 0 ) {
+    perror( "msync" );
+    exit( 1 );
+  }
+
+  if ( rename( temporary.c_str(), _filename.c_str() ) < 0 ) {
+    perror( "rename" );
+    exit( 1 );
+  }
+
+  if ( munmap( old_header, old_length ) < 0 or close( old_fd ) < 0 ) {
+    perror( "munmap" );
+    exit( 1 );
+  }
+}
+
+uint64_t EvalCache::size( void )
+{
+  unique_lock< mutex > lock( _mutex );
+  return _header ? _header->size : 0;
+}
+
+bool EvalCache::lookup( const ContentHash::Key & key, double & score )
+{
+  unique_lock< mutex > lock( _mutex );
+  if ( not _header ) {
+    return false;
+  }
+
+  const Entry * entry = slot( stored_key( key ) );
+  if ( entry->key.a == 0 and entry->key.b == 0 ) {
+    return false;
+  }
+
+  score = entry->score;
+  return true;
+}
+
+void EvalCache::insert( const ContentHash::Key & key, const double score )
+{
+  unique_lock< mutex > lock( _mutex );
+  if ( not _header ) {
+    return;
+  }
+
+  /* keep the load factor under 3/4 */
+  if ( (_header->size + 1) * 4 > _header->capacity * 3 ) {
+    grow();
+  }
+
+  Entry * entry = slot( stored_key( key ) );
+  if ( entry->key.a != 0 or entry->key.b != 0 ) {
+    return;
+  }
+
+  /* fill in the score before the key marks the slot used */
+  entry->score = score;
+  entry->key = stored_key( key );
+  _header->size++;
+}
+
+static string global_eval_cache_file;
+
+void set_global_eval_cache_file( const string & filename )
+{
+  global_eval_cache_file = filename;
+}
+
+EvalCache & global_eval_cache( void )
+{
+  static EvalCache cache( global_eval_cache_file );
+  return cache;
+}
@@ -0,0 +1,58 @@
+#ifndef EVALCACHE_HH
+#define EVALCACHE_HH
+
+#include <mutex>
+#include <string>
+
+#include "contenthash.hh"
+
+/* Scores of single simulation runs, keyed by the ContentHash of
+   everything that determines them (rule tree, seed, network config,
+   tick count). The table lives in a memory-mapped file, so it is
+   shared by every thread in the process and kept for later runs.
+   Only one process may have a file open at a time. */
+class EvalCache
+{
+public:
+  /* bump whenever a change to the simulator alters its results,
+     so that files written by older builds are discarded */
+  static const uint32_t simulator_version = 4;
+
+private:
+  struct Header;
+  struct Entry;
+
+  std::string _filename;
+  int _fd;
+  Header * _header;
+  size_t _mapped_length;
+
+  std::mutex _mutex;
+
+  static size_t file_length( const uint64_t capacity );
+  void map( const int fd, const uint64_t capacity, const bool initialize );
+  void unmap( void );
+  Entry * slot( const ContentHash::Key & key ) const;
+  void grow( void );
+
+public:
+  /* an empty filename gives a cache that is always empty */
+  EvalCache( const std::string & filename );
+  ~EvalCache();
+
+  EvalCache( const EvalCache & ) = delete;
+  EvalCache & operator=( const EvalCache & ) = delete;
+
+  bool enabled( void ) const { return _header != nullptr; }
+  uint64_t size( void );
+
+  bool lookup( const ContentHash::Key & key, double & score );
+  void insert( const ContentHash::Key & key, const double score );
+};
+
+/* must be called before the first use of global_eval_cache() */
+extern void set_global_eval_cache_file( const std::string & filename );
+
+extern EvalCache & global_eval_cache( void );
+
+#endif
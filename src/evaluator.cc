@@ -1,14 +1,31 @@
+#include <atomic>
+#include <cassert>
+#include <deque>
+#include <exception>
 #include <fcntl.h>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 #include "configrange.hh"
 #include "evaluator.hh"
+#include "threadpool.hh"
+#include "evalcache.hh"
+#include "dispatcher.hh"
 #include "network.cc"
 #include "rat-templates.cc"
 #include "fish-templates.cc"
 
 template <typename T>
 Evaluator< T >::Evaluator( const ConfigRange & range )
-  : _prng_seed( global_PRNG()() ), /* freeze the PRNG seed for the life of this Evaluator */
+  : Evaluator( range, global_PRNG()() ) /* freeze the PRNG seed for the life of this Evaluator */
+{
+}
+
+template <typename T>
+Evaluator< T >::Evaluator( const ConfigRange & range, const unsigned int prng_seed )
+  : _prng_seed( prng_seed ),
     _tick_count( range.simulation_ticks ),
     _configs()
 {
@@ -57,80 +74,853 @@ ProblemBuffers::Problem Evaluator< T >::_ProblemSettings_DNA( void ) const
 }
 
 template <>
-ProblemBuffers::Problem Evaluator< WhiskerTree >::DNA( const WhiskerTree & whiskers ) const
+void Evaluator< WhiskerTree >::add_actions_DNA( ProblemBuffers::Problem & problem, const WhiskerTree & whiskers )
 {
-  ProblemBuffers::Problem ret = _ProblemSettings_DNA();
-  ret.mutable_whiskers()->CopyFrom( whiskers.DNA() );
-
-  return ret;
+  problem.mutable_whiskers()->CopyFrom( whiskers.DNA() );
 }
 
 template <>
-ProblemBuffers::Problem Evaluator< FinTree >::DNA( const FinTree & fins ) const
+void Evaluator< FinTree >::add_actions_DNA( ProblemBuffers::Problem & problem, const FinTree & fins )
+{
+  problem.mutable_fins()->CopyFrom( fins.DNA() );
+}
+
+template <typename T>
+ProblemBuffers::Problem Evaluator< T >::DNA( const T & actions ) const
 {
   ProblemBuffers::Problem ret = _ProblemSettings_DNA();
-  ret.mutable_fins()->CopyFrom( fins.DNA() );
+  add_actions_DNA( ret, actions );
 
   return ret;
 }
 
 template <>
-Evaluator< WhiskerTree >::Outcome Evaluator< WhiskerTree >::score( WhiskerTree & run_whiskers,
+Evaluator< WhiskerTree >::Outcome Evaluator< WhiskerTree >::score_config( const CompiledWhiskerTree & run_whiskers,
+             UsageLedger & usage,
              const unsigned int prng_seed,
-             const vector<NetConfig> & configs,
+             const NetConfig & config,
              const bool trace,
              const unsigned int ticks_to_run )
 {
   PRNG run_prng( prng_seed );
 
-  run_whiskers.reset_counts();
+  /* run once */
+  Network<SenderGang<Rat, TimeSwitchedSender<Rat>>,
+    SenderGang<Rat, TimeSwitchedSender<Rat>>> network1( Rat( run_whiskers, usage, trace ), run_prng, config );
+#ifdef REMY_PROFILING
+  const uint64_t lookups_before = usage.total_uses();
+#endif
+
+  network1.run_simulation( ticks_to_run );
 
-  /* run tests */
   Evaluator::Outcome the_outcome;
-  for ( auto &x : configs ) {
-    /* run once */
-    Network<SenderGang<Rat, TimeSwitchedSender<Rat>>,
-      SenderGang<Rat, TimeSwitchedSender<Rat>>> network1( Rat( run_whiskers, trace ), run_prng, x );
-    network1.run_simulation( ticks_to_run );
-    
-    the_outcome.score += network1.senders().utility();
-    the_outcome.throughputs_delays.emplace_back( x, network1.senders().throughputs_delays() );
-  }
+  the_outcome.score = network1.senders().utility();
+  the_outcome.throughputs_delays.emplace_back( config, network1.senders().throughputs_delays() );
 
-  the_outcome.used_actions = run_whiskers;
+#ifdef REMY_PROFILING
+  the_outcome.profiles.push_back( network1.profile() );
+  the_outcome.profiles.back().action_lookups = usage.total_uses() - lookups_before;
+#endif
 
   return the_outcome;
 }
 
 template <>
-Evaluator< FinTree >::Outcome Evaluator< FinTree >::score( FinTree & run_fins,
+Evaluator< FinTree >::Outcome Evaluator< FinTree >::score_config( const CompiledFinTree & run_fins,
+             UsageLedger & usage,
              const unsigned int prng_seed,
-             const vector<NetConfig> & configs,
+             const NetConfig & config,
              const bool trace,
              const unsigned int ticks_to_run )
 {
   PRNG run_prng( prng_seed );
   unsigned int fish_prng_seed( run_prng() );
 
-  run_fins.reset_counts();
+  /* run once */
+  Network<SenderGang<Fish, TimeSwitchedSender<Fish>>,
+    SenderGang<Fish, TimeSwitchedSender<Fish>>> network1( Fish( run_fins, usage, fish_prng_seed, trace ), run_prng, config );
+#ifdef REMY_PROFILING
+  const uint64_t lookups_before = usage.total_uses();
+#endif
+
+  network1.run_simulation( ticks_to_run );
+
+  Evaluator::Outcome the_outcome;
+  the_outcome.score = network1.senders().utility();
+  the_outcome.throughputs_delays.emplace_back( config, network1.senders().throughputs_delays() );
+
+#ifdef REMY_PROFILING
+  the_outcome.profiles.push_back( network1.profile() );
+  the_outcome.profiles.back().action_lookups = usage.total_uses() - lookups_before;
+#endif
+
+  return the_outcome;
+}
+
+/* the results of tasks or dispatched problems, in order; if any
+   failed, e.g. with a DispatchFailure, the first failure is thrown,
+   but only once all have finished, as the tasks may refer to the
+   caller's variables */
+template <typename R>
+static vector< R > get_all( vector< future< R > > & results )
+{
+  vector< R > ret;
+  exception_ptr failure;
+  for ( auto & x : results ) {
+    try {
+      ret.push_back( global_thread_pool().get( x ) );
+    } catch ( ... ) {
+      if ( not failure ) {
+	failure = current_exception();
+      }
+    }
+  }
+
+  if ( failure ) {
+    rethrow_exception( failure );
+  }
+
+  return ret;
+}
+
+/* events between snapshots while waiting for the replaced leaf's
+   first use; each later replacement re-simulates at most this many */
+static const uint64_t snapshot_interval = 4096;
+
+/* Runs network, built on compiled with the first of replacements
+   swapped in, to the end; then runs each other replacement from the
+   last snapshot taken before the replaced leaf was first looked up.
+   Up to that point every replacement makes the same simulation. As
+   each replacement's run finishes, finish( i, network ) is called
+   while run_prng and usage are still the ones it used. */
+template <class NetworkType, class CompiledActions, class ActionType, class Finish>
+static void score_diverging( NetworkType & network,
+			     PRNG & run_prng,
+			     CompiledActions & compiled,
+			     UsageLedger & usage,
+			     const vector< const ActionType * > & replacements,
+			     const unsigned int ticks_to_run,
+			     Finish finish )
+{
+  const unsigned int leaf = compiled.replaced_leaf();
+
+  unique_ptr< NetworkType > snapshot;
+  PRNG snapshot_prng( run_prng );
+  UsageLedger snapshot_usage( usage );
+  bool finished = false;
+  while ( replacements.size() > 1 and not finished and usage.count( leaf ) == 0 ) {
+    snapshot.reset( new NetworkType( network ) );
+    snapshot_prng = run_prng;
+    snapshot_usage = usage;
+    finished = network.run_simulation_events( ticks_to_run, snapshot_interval );
+  }
+  const bool diverged = usage.count( leaf ) > 0;
+
+  network.run_simulation_events( ticks_to_run, numeric_limits< uint64_t >::max() );
+  finish( 0, network );
+
+  for ( unsigned int i = 1; i < replacements.size(); i++ ) {
+    if ( not diverged ) {
+      /* the leaf was never used, so its action didn't matter */
+      finish( i, network );
+      continue;
+    }
+
+    compiled.replace( *replacements.at( i ) );
+    run_prng = snapshot_prng;
+    usage = snapshot_usage;
+    NetworkType rerun( *snapshot );
+    rerun.run_simulation_events( ticks_to_run, numeric_limits< uint64_t >::max() );
+    finish( i, rerun );
+  }
+}
+
+/* A simulation of one config, parked after it was run for some ticks
+   with its own copies of everything it refers to (the caller's tree
+   and replacement are soon gone), so that it can be carried on later. */
+template <class NetworkType, class TreeType, class ActionType>
+struct ParkedRun
+{
+  unsigned int ticks;
+  TreeType actions;
+  ActionType replacement;
+  PRNG prng;
+  CompiledTree< TreeType, ActionType > compiled; /* points into actions and replacement */
+  UsageLedger usage;
+  NetworkType network;
+
+  ParkedRun( const unsigned int s_ticks,
+	     const TreeType & s_actions,
+	     const ActionType & s_replacement,
+	     const PRNG & s_prng,
+	     const UsageLedger & s_usage,
+	     const NetworkType & s_network )
+    : ticks( s_ticks ),
+      actions( s_actions ),
+      replacement( s_replacement ),
+      prng( s_prng ),
+      compiled( actions, &replacement ),
+      usage( s_usage ),
+      network( s_network )
+  {
+    network.rebind( prng, compiled, usage );
+  }
+
+  /* about how many bytes this run takes up; the tree copy is counted
+     as a node and an action per leaf */
+  size_t footprint( void ) const
+  {
+    return sizeof( *this ) - sizeof( compiled ) - sizeof( network )
+      + compiled.footprint() + usage.footprint() + network.footprint()
+      + compiled.num_leaves() * (sizeof( TreeType ) + sizeof( ActionType ));
+  }
+};
+
+/* the runs parked most recently, up to a memory budget; like the
+   other caches here it may forget a run at any time */
+template <class Run>
+struct ParkingLot
+{
+  struct Entry
+  {
+    uint64_t serial; /* tells a run from an earlier one under the same key */
+    size_t bytes;
+    unique_ptr< Run > run;
+  };
+
+  mutex lock;
+  unordered_map< ContentHash::Key, Entry, ContentHash::KeyHash > runs;
+  deque< pair< uint64_t, ContentHash::Key > > order; /* oldest first; may name runs since taken out */
+  uint64_t next_serial;
+  size_t bytes;
+
+  ParkingLot() : lock(), runs(), order(), next_serial( 0 ), bytes( 0 ) {}
+
+  bool current( const pair< uint64_t, ContentHash::Key > & x ) const
+  {
+    const auto entry = runs.find( x.second );
+    return entry != runs.end() and entry->second.serial == x.first;
+  }
+};
+
+static const size_t default_parking_budget = size_t( 256 ) << 20;
+static size_t global_parking_budget = default_parking_budget;
+
+void set_global_parking_budget( const size_t bytes )
+{
+  global_parking_budget = bytes;
+}
+
+/* runs carried on by score_resuming, of either kind of tree */
+static atomic< uint64_t > resumed_runs( 0 );
+
+/* configs given the tree's own score by score_cached, of either kind of tree */
+static atomic< uint64_t > reused_configs( 0 );
+
+template <class Run>
+static ParkingLot< Run > & parking_lot( void )
+{
+  static ParkingLot< Run > lot;
+  return lot;
+}
+
+template <class Run>
+static void park_run( const ContentHash::Key & key, unique_ptr< Run > run )
+{
+  const size_t bytes = run->footprint();
+  if ( bytes > global_parking_budget ) {
+    return;
+  }
+
+  ParkingLot< Run > & lot = parking_lot< Run >();
+  unique_lock< mutex > lock( lot.lock );
+
+  const auto earlier = lot.runs.find( key );
+  if ( earlier != lot.runs.end() ) {
+    lot.bytes -= earlier->second.bytes;
+    lot.runs.erase( earlier );
+  }
+
+  const uint64_t serial = lot.next_serial++;
+  lot.runs.emplace( key, typename ParkingLot< Run >::Entry { serial, bytes, move( run ) } );
+  lot.bytes += bytes;
+  lot.order.emplace_back( serial, key );
+
+  /* forget the oldest runs until the rest fit */
+  while ( not lot.order.empty()
+	  and (lot.bytes > global_parking_budget or not lot.current( lot.order.front() )) ) {
+    if ( lot.current( lot.order.front() ) ) {
+      const auto oldest = lot.runs.find( lot.order.front().second );
+      lot.bytes -= oldest->second.bytes;
+      lot.runs.erase( oldest );
+    }
+    lot.order.pop_front();
+  }
+
+  /* don't let the names of runs taken out pile up */
+  if ( lot.order.size() > 2 * lot.runs.size() + 64 ) {
+    deque< pair< uint64_t, ContentHash::Key > > order;
+    for ( const auto & x : lot.order ) {
+      if ( lot.current( x ) ) {
+	order.push_back( x );
+      }
+    }
+    lot.order.swap( order );
+  }
+}
+
+/* takes out the run parked under key, if it hasn't gone past ticks */
+template <class Run>
+static unique_ptr< Run > unpark_run( const ContentHash::Key & key, const unsigned int ticks )
+{
+  ParkingLot< Run > & lot = parking_lot< Run >();
+  unique_lock< mutex > lock( lot.lock );
+
+  const auto entry = lot.runs.find( key );
+  if ( entry == lot.runs.end() or entry->second.run->ticks > ticks ) {
+    return nullptr;
+  }
+
+  unique_ptr< Run > ret( move( entry->second.run ) );
+  lot.bytes -= entry->second.bytes;
+  lot.runs.erase( entry );
+  return ret;
+}
+
+/* score_config_replacements for either kind of tree; make_network
+   builds the network for a run on compiled, drawing from prng */
+template <class NetworkType, class TreeType, class ActionType, class MakeNetwork>
+static vector< double > score_resuming( const TreeType & actions,
+					const vector< const ActionType * > & replacements,
+					const vector< ContentHash::Key > & run_keys,
+					const unsigned int prng_seed,
+					const unsigned int ticks_to_run,
+					const bool park,
+					MakeNetwork make_network )
+{
+  typedef CompiledTree< TreeType, ActionType > CompiledActions;
+  typedef ParkedRun< NetworkType, TreeType, ActionType > Run;
+
+  vector< double > scores( replacements.size() );
+
+  /* carry on the runs that a shorter evaluation left off */
+  vector< unsigned int > fresh;
+  vector< const ActionType * > fresh_replacements;
+  for ( unsigned int i = 0; i < replacements.size(); i++ ) {
+    unique_ptr< Run > run( unpark_run< Run >( run_keys.at( i ), ticks_to_run ) );
+    if ( not run ) {
+      fresh.push_back( i );
+      fresh_replacements.push_back( replacements.at( i ) );
+      continue;
+    }
+
+    resumed_runs++;
+    run->network.run_simulation_events( ticks_to_run, numeric_limits< uint64_t >::max() );
+    run->ticks = ticks_to_run;
+    scores.at( i ) = run->network.senders().utility();
+    if ( park ) {
+      park_run( run_keys.at( i ), move( run ) );
+    }
+  }
+
+  if ( fresh.empty() ) {
+    return scores;
+  }
+
+  CompiledActions compiled( actions, fresh_replacements.front() );
+  UsageLedger usage( compiled.num_leaves(), false );
+  PRNG run_prng( prng_seed );
+  NetworkType network( make_network( compiled, usage, run_prng ) );
+
+  score_diverging( network, run_prng, compiled, usage, fresh_replacements, ticks_to_run,
+		   [&] ( const unsigned int k, const NetworkType & finished ) {
+		     const unsigned int i = fresh.at( k );
+		     scores.at( i ) = finished.senders().utility();
+		     if ( park ) {
+		       park_run( run_keys.at( i ), unique_ptr< Run >( new Run( ticks_to_run, actions, *replacements.at( i ),
+									       run_prng, usage, finished ) ) );
+		     } } );
+
+  return scores;
+}
+
+template <>
+vector< double > Evaluator< WhiskerTree >::score_config_replacements( const WhiskerTree & actions,
+             const vector< const Whisker * > & replacements,
+             const vector< ContentHash::Key > & run_keys,
+             const unsigned int prng_seed,
+             const NetConfig & config,
+             const unsigned int ticks_to_run,
+             const bool park )
+{
+  typedef Network<SenderGang<Rat, TimeSwitchedSender<Rat>>,
+    SenderGang<Rat, TimeSwitchedSender<Rat>>> NetworkType;
+
+  return score_resuming< NetworkType >( actions, replacements, run_keys, prng_seed, ticks_to_run, park,
+					[&] ( const CompiledWhiskerTree & compiled, UsageLedger & usage, PRNG & run_prng ) {
+					  return NetworkType( Rat( compiled, usage, false ), run_prng, config ); } );
+}
+
+template <>
+vector< double > Evaluator< FinTree >::score_config_replacements( const FinTree & actions,
+             const vector< const Fin * > & replacements,
+             const vector< ContentHash::Key > & run_keys,
+             const unsigned int prng_seed,
+             const NetConfig & config,
+             const unsigned int ticks_to_run,
+             const bool park )
+{
+  typedef Network<SenderGang<Fish, TimeSwitchedSender<Fish>>,
+    SenderGang<Fish, TimeSwitchedSender<Fish>>> NetworkType;
+
+  return score_resuming< NetworkType >( actions, replacements, run_keys, prng_seed, ticks_to_run, park,
+					[&] ( const CompiledFinTree & compiled, UsageLedger & usage, PRNG & run_prng ) {
+					  unsigned int fish_prng_seed( run_prng() );
+					  return NetworkType( Fish( compiled, usage, fish_prng_seed, false ), run_prng, config ); } );
+}
+
+template <typename T>
+vector< unsigned int > Evaluator< T >::config_seeds( const unsigned int prng_seed,
+						     const unsigned int num_configs )
+{
+  /* give every config its own PRNG, seeded from this one, so that
+     the result doesn't depend on the order in which the configs are
+     run; a 32-bit seed is all a Problem carries to a worker */
+  PRNG seed_prng( prng_seed );
+  vector< unsigned int > ret;
+  for ( unsigned int i = 0; i < num_configs; i++ ) {
+    ret.push_back( seed_prng() );
+  }
+  return ret;
+}
+
+template <typename T>
+vector< typename Evaluator< T >::Outcome > Evaluator< T >::score_compiled( const CompiledActions & run_actions,
+             UsageLedger & usage,
+             const vector< unsigned int > & seeds,
+             const vector<NetConfig> & configs,
+             const bool trace,
+             const unsigned int ticks_to_run )
+{
+  assert( seeds.size() == configs.size() );
 
   /* run tests */
+  vector< Evaluator::Outcome > config_outcomes;
+  vector< UsageLedger > config_usage;
+  if ( configs.size() < 2 ) {
+    for ( unsigned int i = 0; i < configs.size(); i++ ) {
+      config_outcomes.push_back( score_config( run_actions, usage, seeds.at( i ),
+					       configs.at( i ), trace, ticks_to_run ) );
+    }
+    config_usage.assign( configs.size(), usage );
+  } else {
+    /* every config shares the compiled tree and keeps its own ledger,
+       merged in config order so the medians don't depend on scheduling */
+    config_usage.assign( configs.size(), UsageLedger( usage.num_leaves(), trace ) );
+    vector< future< Evaluator::Outcome > > runs;
+    for ( unsigned int i = 0; i < configs.size(); i++ ) {
+      runs.push_back( global_thread_pool().submit( [&, i] () {
+	    return score_config( run_actions, config_usage.at( i ), seeds.at( i ),
+				 configs.at( i ), trace, ticks_to_run ); } ) );
+    }
+
+    for ( auto & x : runs ) {
+      config_outcomes.push_back( global_thread_pool().get( x ) );
+    }
+
+    for ( const auto & x : config_usage ) {
+      usage.merge( x );
+    }
+  }
+
+  /* note which leaves each config used, for scoring replacements */
+  const ContentHash::Key tree_key = run_actions.fingerprint();
+  for ( unsigned int i = 0; i < configs.size(); i++ ) {
+    ConfigUsage x { config_outcomes.at( i ).score, vector< bool >( usage.num_leaves() ) };
+    for ( unsigned int leaf = 0; leaf < usage.num_leaves(); leaf++ ) {
+      x.used.at( leaf ) = config_usage.at( i ).count( leaf ) > 0;
+    }
+    remember_config_usage( cache_key( tree_key, seeds.at( i ), configs.at( i ).DNA().SerializeAsString(),
+				      ticks_to_run ), x );
+  }
+
+  return config_outcomes;
+}
+
+template <typename T>
+struct Evaluator< T >::ConfigUsageMemo
+{
+  mutex lock;
+  unordered_map< ContentHash::Key, ConfigUsage, ContentHash::KeyHash > entries;
+  deque< ContentHash::Key > order; /* oldest first */
+
+  ConfigUsageMemo() : lock(), entries(), order() {}
+};
+
+template <typename T>
+struct Evaluator< T >::OutcomeMemo
+{
+  mutex lock;
+  deque< MemoizedOutcome > entries;
+
+  OutcomeMemo() : lock(), entries() {}
+};
+
+template <typename T>
+typename Evaluator< T >::OutcomeMemo & Evaluator< T >::outcome_memo( void )
+{
+  static OutcomeMemo memo;
+  return memo;
+}
+
+template <typename T>
+typename Evaluator< T >::ConfigUsageMemo & Evaluator< T >::config_usage_memo( void )
+{
+  static ConfigUsageMemo memo;
+  return memo;
+}
+
+template <typename T>
+void Evaluator< T >::remember_config_usage( const ContentHash::Key & key, const ConfigUsage & usage )
+{
+  ConfigUsageMemo & memo = config_usage_memo();
+  unique_lock< mutex > lock( memo.lock );
+
+  if ( not memo.entries.emplace( key, usage ).second ) {
+    return;
+  }
+
+  memo.order.push_back( key );
+  if ( memo.order.size() > config_usage_capacity ) {
+    memo.entries.erase( memo.order.front() );
+    memo.order.pop_front();
+  }
+}
+
+template <typename T>
+bool Evaluator< T >::recall_config_usage( const ContentHash::Key & key, ConfigUsage & usage )
+{
+  ConfigUsageMemo & memo = config_usage_memo();
+  unique_lock< mutex > lock( memo.lock );
+
+  const auto entry = memo.entries.find( key );
+  if ( entry == memo.entries.end() ) {
+    return false;
+  }
+
+  usage = entry->second;
+  return true;
+}
+
+template <typename T>
+typename Evaluator< T >::Outcome Evaluator< T >::total( const vector< Outcome > & config_outcomes )
+{
   Evaluator::Outcome the_outcome;
-  for ( auto &x : configs ) {
-    /* run once */
-    Network<SenderGang<Fish, TimeSwitchedSender<Fish>>,
-      SenderGang<Fish, TimeSwitchedSender<Fish>>> network1( Fish( run_fins, fish_prng_seed, trace ), run_prng, x );
-    network1.run_simulation( ticks_to_run );
-    
-    the_outcome.score += network1.senders().utility();
-    the_outcome.throughputs_delays.emplace_back( x, network1.senders().throughputs_delays() );
+  for ( const auto & x : config_outcomes ) {
+    the_outcome.score += x.score;
+    the_outcome.throughputs_delays.push_back( x.throughputs_delays.front() );
+    the_outcome.profiles.insert( the_outcome.profiles.end(), x.profiles.begin(), x.profiles.end() );
+  }
+
+  return the_outcome;
+}
+
+template <typename T>
+ContentHash::Key Evaluator< T >::cache_key( const ContentHash::Key & tree_key,
+					    const unsigned int seed,
+					    const string & config_DNA,
+					    const unsigned int ticks_to_run )
+{
+  ContentHash key;
+  key.add_value( tree_key );
+  key.add_value( seed );
+  key.add( config_DNA );
+  key.add_value( ticks_to_run );
+  return key.key();
+}
+
+template <typename T>
+vector< double > Evaluator< T >::score_cached( const T & actions,
+					       const ActionType * replacement,
+					       const vector< unsigned int > & seeds,
+					       const vector<NetConfig> & configs,
+					       const unsigned int ticks_to_run )
+{
+  const CompiledActions compiled( actions, replacement );
+
+  EvalCache & cache = global_eval_cache();
+  const ContentHash::Key tree_key = compiled.fingerprint();
+
+  /* look up every config, and run the ones that aren't known */
+  vector< double > scores( configs.size() );
+  vector< ContentHash::Key > keys;
+  vector< unsigned int > missing, missing_seeds;
+  vector< NetConfig > missing_configs;
+  for ( unsigned int i = 0; i < configs.size(); i++ ) {
+    keys.push_back( cache_key( tree_key, seeds.at( i ), configs.at( i ).DNA().SerializeAsString(), ticks_to_run ) );
+
+    if ( not cache.lookup( keys.back(), scores.at( i ) ) ) {
+      missing.push_back( i );
+      missing_seeds.push_back( seeds.at( i ) );
+      missing_configs.push_back( configs.at( i ) );
+    }
+  }
+
+  if ( missing.empty() ) {
+    return scores;
+  }
+
+  vector< double > missing_scores;
+  if ( global_dispatcher().enabled() ) {
+    /* one problem per config, so they spread over the workers */
+    T remote_actions( actions );
+    if ( replacement and not remote_actions.replace( *replacement ) ) {
+      fprintf( stderr, "Replacement %s is not in the tree.\n", replacement->str().c_str() );
+      exit( 1 );
+    }
+
+    vector< future< AnswerBuffers::Outcome > > answers;
+    for ( unsigned int j = 0; j < missing.size(); j++ ) {
+      ProblemBuffers::Problem problem;
+      problem.mutable_settings()->set_tick_count( ticks_to_run );
+      problem.mutable_settings()->add_config_seeds( missing_seeds.at( j ) );
+      problem.add_configs()->CopyFrom( missing_configs.at( j ).DNA() );
+      add_actions_DNA( problem, remote_actions );
+      answers.push_back( global_dispatcher().submit( problem ) );
+    }
+
+    for ( const auto & x : get_all( answers ) ) {
+      missing_scores.push_back( x.score() );
+    }
+  } else {
+    UsageLedger usage( compiled.num_leaves(), false );
+    for ( const auto & x : score_compiled( compiled, usage, missing_seeds,
+					   missing_configs, false, ticks_to_run ) ) {
+      missing_scores.push_back( x.score );
+    }
+  }
+
+  for ( unsigned int j = 0; j < missing.size(); j++ ) {
+    scores.at( missing.at( j ) ) = missing_scores.at( j );
+    cache.insert( keys.at( missing.at( j ) ), missing_scores.at( j ) );
+  }
+
+  return scores;
+}
+
+template <typename T>
+vector< vector< double > > Evaluator< T >::score_cached( const T & actions,
+							 const vector< ActionType > & replacements,
+							 const vector< unsigned int > & seeds,
+							 const vector<NetConfig> & configs,
+							 const unsigned int ticks_to_run,
+							 const bool park )
+{
+  const ContentHash::Key tree_key = CompiledActions( actions ).fingerprint();
+  const unsigned int leaf = CompiledActions( actions, &replacements.front() ).replaced_leaf();
+
+  /* a config that never reached the leaf plays out the same whatever
+     the leaf's action is */
+  vector< vector< double > > scores( replacements.size(), vector< double >( configs.size() ) );
+  vector< unsigned int > missing, missing_seeds;
+  vector< NetConfig > missing_configs;
+  for ( unsigned int i = 0; i < configs.size(); i++ ) {
+    ConfigUsage usage { 0, {} };
+    if ( recall_config_usage( cache_key( tree_key, seeds.at( i ), configs.at( i ).DNA().SerializeAsString(), ticks_to_run ), usage )
+	 and not usage.used.at( leaf ) ) {
+      reused_configs++;
+      for ( auto & x : scores ) {
+	x.at( i ) = usage.score;
+      }
+    } else {
+      missing.push_back( i );
+      missing_seeds.push_back( seeds.at( i ) );
+      missing_configs.push_back( configs.at( i ) );
+    }
+  }
+
+  if ( missing.empty() ) {
+    return scores;
+  }
+
+  const auto missing_scores = score_together( actions, replacements, missing_seeds, missing_configs, ticks_to_run, park );
+  for ( unsigned int j = 0; j < replacements.size(); j++ ) {
+    for ( unsigned int k = 0; k < missing.size(); k++ ) {
+      scores.at( j ).at( missing.at( k ) ) = missing_scores.at( j ).at( k );
+    }
+  }
+
+  return scores;
+}
+
+template <typename T>
+vector< vector< double > > Evaluator< T >::score_together( const T & actions,
+							   const vector< ActionType > & replacements,
+							   const vector< unsigned int > & seeds,
+							   const vector<NetConfig> & configs,
+							   const unsigned int ticks_to_run,
+							   const bool park )
+{
+  if ( global_dispatcher().enabled() ) {
+    /* the workers take one tree per problem */
+    vector< future< vector< double > > > runs;
+    for ( const auto & x : replacements ) {
+      runs.push_back( global_thread_pool().submit( [&] () {
+	    return score_cached( actions, &x, seeds, configs, ticks_to_run ); } ) );
+    }
+
+    return get_all( runs );
   }
 
-  the_outcome.used_actions = run_fins;
+  EvalCache & cache = global_eval_cache();
+
+  vector< string > configs_DNA;
+  for ( const auto & x : configs ) {
+    configs_DNA.push_back( x.DNA().SerializeAsString() );
+  }
+
+  /* look up every pair, and list per config the replacements to run */
+  vector< vector< double > > scores( replacements.size(), vector< double >( configs.size() ) );
+  vector< vector< ContentHash::Key > > keys( replacements.size() ), run_keys( replacements.size() );
+  vector< vector< unsigned int > > missing( configs.size() );
+  for ( unsigned int j = 0; j < replacements.size(); j++ ) {
+    const ContentHash::Key tree_key = CompiledActions( actions, &replacements.at( j ) ).fingerprint();
+    for ( unsigned int i = 0; i < configs.size(); i++ ) {
+      keys.at( j ).push_back( cache_key( tree_key, seeds.at( i ), configs_DNA.at( i ), ticks_to_run ) );
+      /* a run is parked under a key that leaves out how far it has got */
+      run_keys.at( j ).push_back( cache_key( tree_key, seeds.at( i ), configs_DNA.at( i ), 0 ) );
+      if ( not cache.lookup( keys.at( j ).back(), scores.at( j ).at( i ) ) ) {
+	missing.at( i ).push_back( j );
+      }
+    }
+  }
+
+  vector< future< vector< double > > > runs( configs.size() );
+  for ( unsigned int i = 0; i < configs.size(); i++ ) {
+    if ( missing.at( i ).empty() ) {
+      continue;
+    }
+
+    runs.at( i ) = global_thread_pool().submit( [&, i] () {
+	vector< const ActionType * > batch;
+	vector< ContentHash::Key > batch_keys;
+	for ( const auto & j : missing.at( i ) ) {
+	  batch.push_back( &replacements.at( j ) );
+	  batch_keys.push_back( run_keys.at( j ).at( i ) );
+	}
+	return score_config_replacements( actions, batch, batch_keys, seeds.at( i ), configs.at( i ),
+					  ticks_to_run, park ); } );
+  }
+
+  for ( unsigned int i = 0; i < configs.size(); i++ ) {
+    if ( missing.at( i ).empty() ) {
+      continue;
+    }
+
+    const vector< double > config_scores( global_thread_pool().get( runs.at( i ) ) );
+    for ( unsigned int k = 0; k < missing.at( i ).size(); k++ ) {
+      const unsigned int j = missing.at( i ).at( k );
+      scores.at( j ).at( i ) = config_scores.at( k );
+      cache.insert( keys.at( j ).at( i ), config_scores.at( k ) );
+    }
+  }
+
+  return scores;
+}
+
+template <typename T>
+typename Evaluator< T >::Outcome Evaluator< T >::score( T & run_actions,
+             const unsigned int prng_seed,
+             const vector<NetConfig> & configs,
+             const bool trace,
+             const unsigned int ticks_to_run )
+{
+  return score_with_seeds( run_actions, config_seeds( prng_seed, configs.size() ),
+			   configs, trace, ticks_to_run );
+}
+
+template <typename T>
+typename Evaluator< T >::Outcome Evaluator< T >::score_with_seeds( T & run_actions,
+             const vector< unsigned int > & seeds,
+             const vector<NetConfig> & configs,
+             const bool trace,
+             const unsigned int ticks_to_run )
+{
+  const CompiledActions compiled( run_actions );
+
+  /* the outcomes of recent evaluations, keyed by the tree's behaviour
+     (not its generations) and everything else that determines them, so
+     that a tree which has only been promoted, or is scored again the
+     same way, isn't simulated twice */
+  OutcomeMemo & memo = outcome_memo();
+  const uint64_t cost = uint64_t( ticks_to_run ) * configs.size();
+
+  ContentHash hash;
+  hash.add_value( compiled.fingerprint() );
+  for ( unsigned int i = 0; i < configs.size(); i++ ) {
+    hash.add_value( seeds.at( i ) );
+    hash.add( configs.at( i ).DNA().SerializeAsString() );
+  }
+  hash.add_value( ticks_to_run );
+  hash.add_value( trace );
+  const ContentHash::Key key = hash.key();
+
+  {
+    unique_lock< mutex > lock( memo.lock );
+    for ( const auto & x : memo.entries ) {
+      if ( x.key == key ) {
+	run_actions.apply_usage( x.usage );
+	Evaluator::Outcome the_outcome( x.outcome );
+	the_outcome.used_actions = run_actions;
+	return the_outcome;
+      }
+    }
+  }
+
+  UsageLedger usage( compiled.num_leaves(), trace );
+
+  Evaluator::Outcome the_outcome = total( score_compiled( compiled, usage, seeds,
+							  configs, trace, ticks_to_run ) );
+
+  {
+    unique_lock< mutex > lock( memo.lock );
+    /* make room by dropping the oldest of the cheapest outcomes to
+       simulate, so a few long runs outlive many short ones */
+    if ( memo.entries.size() == outcome_memo_capacity ) {
+      auto victim = memo.entries.begin();
+      for ( auto x = memo.entries.begin(); x != memo.entries.end(); x++ ) {
+	if ( x->cost < victim->cost ) {
+	  victim = x;
+	}
+      }
+      memo.entries.erase( victim );
+    }
+    memo.entries.push_back( MemoizedOutcome { key, cost, the_outcome, usage } );
+  }
+
+  run_actions.apply_usage( usage );
+  the_outcome.used_actions = run_actions;
 
   return the_outcome;
 }
 
+template <typename T>
+vector< unsigned int > Evaluator< T >::problem_seeds( const ProblemBuffers::Problem & problem )
+{
+  const auto & settings = problem.settings();
+  if ( settings.config_seeds_size() == 0 ) {
+    return config_seeds( settings.prng_seed(), problem.configs_size() );
+  }
+
+  if ( settings.config_seeds_size() != problem.configs_size() ) {
+    fprintf( stderr, "Problem has %d seeds for %d configs.\n",
+	     settings.config_seeds_size(), problem.configs_size() );
+    exit( 1 );
+  }
+
+  return vector< unsigned int >( settings.config_seeds().begin(), settings.config_seeds().end() );
+}
+
 template <>
 typename Evaluator< WhiskerTree >::Outcome Evaluator< WhiskerTree >::parse_problem_and_evaluate( const ProblemBuffers::Problem & problem )
 {
@@ -141,7 +931,7 @@ typename Evaluator< WhiskerTree >::Outcome Evaluator< WhiskerTree >::parse_probl
 
   WhiskerTree run_whiskers = WhiskerTree( problem.whiskers() );
 
-  return Evaluator< WhiskerTree >::score( run_whiskers, problem.settings().prng_seed(),
+  return score_with_seeds( run_whiskers, problem_seeds( problem ),
 			   configs, false, problem.settings().tick_count() );
 }
 
@@ -155,8 +945,8 @@ typename Evaluator< FinTree >::Outcome Evaluator< FinTree >::parse_problem_and_e
 
   FinTree run_fins = FinTree( problem.fins() );
 
-  return Evaluator< FinTree >::score( run_fins, problem.settings().prng_seed(),
-         configs, false, problem.settings().tick_count() );
+  return score_with_seeds( run_fins, problem_seeds( problem ),
+			   configs, false, problem.settings().tick_count() );
 }
 
 template <typename T>
@@ -182,7 +972,7 @@ AnswerBuffers::Outcome Evaluator< T >::Outcome::DNA( void ) const
 
 template <typename T>
 Evaluator< T >::Outcome::Outcome( const AnswerBuffers::Outcome & dna )
-  : score( dna.score() ), throughputs_delays(), used_actions() {
+  : score( dna.score() ), throughputs_delays(), used_actions(), profiles() {
   for ( const auto &x : dna.throughputs_delays() ) {
     vector< pair< double, double > > tp_del;
     for ( const auto &result : x.results() ) {
@@ -200,6 +990,49 @@ typename Evaluator< T >::Outcome Evaluator< T >::score( T & run_actions,
   return score( run_actions, _prng_seed, _configs, trace, _tick_count * carefulness );
 }
 
+template <typename T>
+vector< vector< double > > Evaluator< T >::score_replacements( const T & actions,
+							       const vector< ActionType > & replacements,
+							       const double carefulness,
+							       const unsigned int num_configs ) const
+{
+  vector< unsigned int > seeds;
+  vector< NetConfig > configs;
+  sample_configs( num_configs, seeds, configs );
+
+  /* a shortened run may be carried on by the full evaluation */
+  const unsigned int ticks_to_run = _tick_count * carefulness;
+  return score_cached( actions, replacements, seeds, configs, ticks_to_run, ticks_to_run < _tick_count );
+}
+
+template <typename T>
+uint64_t Evaluator< T >::runs_resumed( void )
+{
+  return resumed_runs;
+}
+
+template <typename T>
+uint64_t Evaluator< T >::configs_reused( void )
+{
+  return reused_configs;
+}
+
+template <typename T>
+void Evaluator< T >::sample_configs( const unsigned int num_configs,
+				     vector< unsigned int > & seeds,
+				     vector< NetConfig > & configs ) const
+{
+  assert( num_configs > 0 and num_configs <= _configs.size() );
+
+  /* spread the sample evenly over the configs (which are in grid order),
+     keeping the seed each config gets in a full evaluation */
+  const vector< unsigned int > all_seeds( config_seeds( _prng_seed, _configs.size() ) );
+  for ( unsigned int i = 0; i < num_configs; i++ ) {
+    const unsigned int index = uint64_t( i ) * _configs.size() / num_configs;
+    seeds.push_back( all_seeds.at( index ) );
+    configs.push_back( _configs.at( index ) );
+  }
+}
 
 template class Evaluator< WhiskerTree>;
 template class Evaluator< FinTree >;
@@ -7,6 +7,8 @@
 #include "random.hh"
 #include "whiskertree.hh"
 #include "fintree.hh"
+#include "compiledtree.hh"
+#include "usageledger.hh"
 #include "network.hh"
 #include "problem.pb.h"
 #include "answer.pb.h"
@@ -15,6 +17,9 @@ template <typename T>
 class Evaluator
 {
 public:
+  typedef typename T::ActionType ActionType;
+  typedef CompiledTree< T, ActionType > CompiledActions;
+
   class Outcome
   {
   public:
@@ -22,7 +27,10 @@ public:
     std::vector< std::pair< NetConfig, std::vector< std::pair< double, double > > > > throughputs_delays;
     T used_actions;
 
-    Outcome() : score( 0 ), throughputs_delays(), used_actions() {}
+    /* one per config, like throughputs_delays; empty unless built with --enable-profiling */
+    std::vector< SimulationProfile > profiles;
+
+    Outcome() : score( 0 ), throughputs_delays(), used_actions(), profiles() {}
 
     Outcome( const AnswerBuffers::Outcome & dna );
 
@@ -30,6 +38,50 @@ public:
   };
 
 private:
+  /* a whole-tree outcome kept by score_with_seeds, with the usage
+     that produced it (the used_actions are rebuilt from the caller's tree) */
+  struct MemoizedOutcome
+  {
+    ContentHash::Key key;
+    uint64_t cost; /* ticks times configs */
+    Outcome outcome;
+    UsageLedger usage;
+  };
+
+  /* Recent whole-tree outcomes, shared by every Evaluator in the
+     process: the breeder builds a new Evaluator, with the same seed,
+     for each step, and it is across them that a promoted tree (or,
+     with a fixed careful seed, last round's best) is scored again. */
+  struct OutcomeMemo;
+  static OutcomeMemo & outcome_memo( void );
+
+  /* the memo is only a shortcut for a tree scored again soon after,
+     so it needs few entries; each holds a throughput and delay per
+     sender and config and a count per leaf, and the cheapest to
+     simulate again are dropped first */
+  static const unsigned int outcome_memo_capacity = 16;
+
+  /* the result of one config simulated by score_compiled, and which
+     leaves of the tree it used */
+  struct ConfigUsage
+  {
+    double score;
+    std::vector< bool > used;
+  };
+
+  /* per-config usage of recent whole-tree evaluations, also shared by
+     every Evaluator; the replacements for an action are scored right
+     after the tree they go in, so this only has to hold the configs of
+     the last few evaluations, even of large config ranges. An entry is
+     a score and a bit per leaf. */
+  static const unsigned int config_usage_capacity = 4096;
+
+  struct ConfigUsageMemo;
+  static ConfigUsageMemo & config_usage_memo( void );
+
+  static void remember_config_usage( const ContentHash::Key & key, const ConfigUsage & usage );
+  static bool recall_config_usage( const ContentHash::Key & key, ConfigUsage & usage );
+
   const unsigned int _prng_seed;
   unsigned int _tick_count;
 
@@ -37,8 +89,92 @@ private:
 
   ProblemBuffers::Problem _ProblemSettings_DNA ( void ) const;
 
+  static void add_actions_DNA( ProblemBuffers::Problem & problem, const T & actions );
+
+  static Outcome score_config( const CompiledActions & run_actions,
+			       UsageLedger & usage,
+			       const unsigned int prng_seed,
+			       const NetConfig & config,
+			       const bool trace,
+			       const unsigned int ticks_to_run );
+
+  /* scores of one config with each of several replacements for the
+     same leaf, sharing the simulation up to that leaf's first use.
+     A replacement whose run was parked under its run_key by a shorter
+     evaluation carries on from there instead; with park, each run is
+     parked in turn when it's done. */
+  static std::vector< double > score_config_replacements( const T & actions,
+							  const std::vector< const ActionType * > & replacements,
+							  const std::vector< ContentHash::Key > & run_keys,
+							  const unsigned int prng_seed,
+							  const NetConfig & config,
+							  const unsigned int ticks_to_run,
+							  const bool park );
+
+  static std::vector< unsigned int > config_seeds( const unsigned int prng_seed,
+						   const unsigned int num_configs );
+
+  /* one outcome per config, in order */
+  static std::vector< Outcome > score_compiled( const CompiledActions & run_actions,
+						UsageLedger & usage,
+						const std::vector< unsigned int > & seeds,
+						const std::vector<NetConfig> & configs,
+						const bool trace,
+						const unsigned int ticks_to_run );
+
+  static Outcome total( const std::vector< Outcome > & config_outcomes );
+
+  /* per-config scores of actions (with replacement, if given), from
+     the global EvalCache where possible and otherwise simulated here or
+     by the global Dispatcher's workers */
+  static std::vector< double > score_cached( const T & actions,
+					     const ActionType * replacement,
+					     const std::vector< unsigned int > & seeds,
+					     const std::vector<NetConfig> & configs,
+					     const unsigned int ticks_to_run );
+
+  /* the same, for several replacements of one leaf; one list of
+     per-config scores per replacement. Configs in which the tree
+     without replacement was simulated the same way and never used the
+     leaf aren't simulated again. With park, the simulations are kept
+     so that a longer evaluation of the same can carry them on. */
+  static std::vector< std::vector< double > > score_cached( const T & actions,
+							    const std::vector< ActionType > & replacements,
+							    const std::vector< unsigned int > & seeds,
+							    const std::vector<NetConfig> & configs,
+							    const unsigned int ticks_to_run,
+							    const bool park );
+
+  /* the rest of the same, running every config */
+  static std::vector< std::vector< double > > score_together( const T & actions,
+							      const std::vector< ActionType > & replacements,
+							      const std::vector< unsigned int > & seeds,
+							      const std::vector<NetConfig> & configs,
+							      const unsigned int ticks_to_run,
+							      const bool park );
+
+  static ContentHash::Key cache_key( const ContentHash::Key & tree_key,
+				     const unsigned int seed,
+				     const std::string & config_DNA,
+				     const unsigned int ticks_to_run );
+
+  /* num_configs of the configs, spread evenly over the range, with
+     the seeds they get in a full evaluation */
+  void sample_configs( const unsigned int num_configs,
+		       std::vector< unsigned int > & seeds,
+		       std::vector< NetConfig > & configs ) const;
+
+  static Outcome score_with_seeds( T & run_actions,
+				   const std::vector< unsigned int > & seeds,
+				   const std::vector<NetConfig> & configs,
+				   const bool trace,
+				   const unsigned int ticks_to_run );
+
 public:
   Evaluator( const ConfigRange & range );
+  Evaluator( const ConfigRange & range, const unsigned int prng_seed );
+
+  unsigned int prng_seed( void ) const { return _prng_seed; }
   
   ProblemBuffers::Problem DNA( const T & actions ) const;
 
@@ -46,8 +182,35 @@ public:
 		const bool trace = false,
 		const double carefulness = 1) const;
 
+  /* per-config scores of actions with one leaf's action swapped for
+     each of several replacements (matched by domain), on num_configs
+     of the configs spread evenly over the range; each config is run
+     with the same seed as in a full evaluation, and neither the tree
+     nor its counts are modified. The simulation is shared between the
+     replacements until they first make a difference. Runs shorter
+     than a full evaluation are kept for a while, and a later, longer
+     evaluation of the same replacement carries them on rather than
+     starting again. */
+  std::vector< std::vector< double > > score_replacements( const T & actions,
+							   const std::vector< ActionType > & replacements,
+							   const double carefulness,
+							   const unsigned int num_configs ) const;
+
+  unsigned int num_configs( void ) const { return _configs.size(); }
+
+  /* how many runs score_replacements has carried on from a shorter
+     evaluation so far, in this process */
+  static uint64_t runs_resumed( void );
+
+  /* how many configs score_replacements has given the tree's own
+     score, because the tree never used the replaced leaf in them */
+  static uint64_t configs_reused( void );
+
   static Evaluator::Outcome parse_problem_and_evaluate( const ProblemBuffers::Problem & problem );
 
+  /* the PRNG seed each of a problem's configs is run with */
+  static std::vector< unsigned int > problem_seeds( const ProblemBuffers::Problem & problem );
+
   static Outcome score( T & run_actions,
 			const unsigned int prng_seed,
 			const std::vector<NetConfig> & configs,
@@ -55,4 +218,10 @@ public:
 			const unsigned int ticks_to_run );
 };
 
+/* how many bytes of shortened runs score_replacements may keep for a
+   longer evaluation to carry on, oldest forgotten first (256 MiB if not
+   set; 0 keeps none, so every evaluation starts from the beginning).
+   Must be called before the first evaluation. */
+extern void set_global_parking_budget( const size_t bytes );
+
 #endif
@@ -0,0 +1,108 @@
+#include <cassert>
+#include <utility>
+
+#include "eventqueue.hh"
+
+using namespace std;
+
+EventQueue::EventQueue( const unsigned int num_elements )
+  : _times( num_elements, numeric_limits<double>::max() ),
+    _heap(),
+    _position()
+{
+  for ( unsigned int i = 0; i < num_elements; i++ ) {
+    _heap.push_back( i );
+    _position.push_back( i );
+  }
+}
+
+bool EventQueue::earlier( const unsigned int pos_a, const unsigned int pos_b ) const
+{
+  const unsigned int a = _heap[ pos_a ], b = _heap[ pos_b ];
+  return _times[ a ] < _times[ b ] or ( _times[ a ] == _times[ b ] and a < b );
+}
+
+void EventQueue::swap_entries( const unsigned int pos_a, const unsigned int pos_b )
+{
+  swap( _heap[ pos_a ], _heap[ pos_b ] );
+  _position[ _heap[ pos_a ] ] = pos_a;
+  _position[ _heap[ pos_b ] ] = pos_b;
+}
+
+void EventQueue::sift_up( unsigned int pos )
+{
+  while ( pos > 0 ) {
+    const unsigned int parent = (pos - 1) / 2;
+    if ( not earlier( pos, parent ) ) {
+      return;
+    }
+    swap_entries( pos, parent );
+    pos = parent;
+  }
+}
+
+void EventQueue::sift_down( unsigned int pos )
+{
+  while ( true ) {
+    const unsigned int left = 2 * pos + 1, right = left + 1;
+    unsigned int first = pos;
+
+    if ( left < _heap.size() and earlier( left, first ) ) {
+      first = left;
+    }
+
+    if ( right < _heap.size() and earlier( right, first ) ) {
+      first = right;
+    }
+
+    if ( first == pos ) {
+      return;
+    }
+
+    swap_entries( pos, first );
+    pos = first;
+  }
+}
+
+void EventQueue::update( const unsigned int element, const double & time )
+{
+  assert( element < _times.size() );
+
+  if ( _times[ element ] == time ) {
+    return;
+  }
+
+  const bool moved_earlier = time < _times[ element ];
+  _times[ element ] = time;
+
+  if ( moved_earlier ) {
+    sift_up( _position[ element ] );
+  } else {
+    sift_down( _position[ element ] );
+  }
+}
+
+void EventQueue::due( const double & time, vector< unsigned int > & out ) const
+{
+  /* walk down from the root; the heap order means no element below
+     one that isn't due can be due, so this costs O(number due) */
+  const size_t first = out.size();
+  if ( not _heap.empty() and _times[ _heap.front() ] <= time ) {
+    out.push_back( 0 );
+  }
+
+  for ( size_t i = first; i < out.size(); i++ ) {
+    const unsigned int left = 2 * out[ i ] + 1, right = left + 1;
+    if ( left < _heap.size() and _times[ _heap[ left ] ] <= time ) {
+      out.push_back( left );
+    }
+    if ( right < _heap.size() and _times[ _heap[ right ] ] <= time ) {
+      out.push_back( right );
+    }
+  }
+
+  /* positions to elements */
+  for ( size_t i = first; i < out.size(); i++ ) {
+    out[ i ] = _heap[ out[ i ] ];
+  }
+}
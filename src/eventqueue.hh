@@ -0,0 +1,50 @@
+#ifndef EVENTQUEUE_HH
+#define EVENTQUEUE_HH
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+/* Indexed min-heap holding the next event time of each of a fixed
+   set of elements (e.g. the senders in a gang). Changing one element's
+   time costs O(log n); finding the soonest event costs O(1). */
+class EventQueue
+{
+private:
+  std::vector< double > _times; /* next event time of each element */
+  std::vector< unsigned int > _heap; /* elements in heap order */
+  std::vector< unsigned int > _position; /* where each element sits in _heap */
+
+  bool earlier( const unsigned int pos_a, const unsigned int pos_b ) const;
+  void swap_entries( const unsigned int pos_a, const unsigned int pos_b );
+  void sift_up( unsigned int pos );
+  void sift_down( unsigned int pos );
+
+public:
+  EventQueue( const unsigned int num_elements = 0 );
+
+  void update( const unsigned int element, const double & time );
+
+  /* append every element whose event time is at or before time */
+  void due( const double & time, std::vector< unsigned int > & out ) const;
+
+  unsigned int size( void ) const { return _times.size(); }
+  const double & event_time( const unsigned int element ) const { return _times[ element ]; }
+
+  /* element with the soonest event (ties go to the lowest index) */
+  unsigned int soonest( void ) const { return _heap.front(); }
+
+  double next_event_time( void ) const
+  {
+    return _heap.empty() ? std::numeric_limits<double>::max() : _times[ _heap.front() ];
+  }
+
+  /* bytes held on the heap */
+  size_t footprint( void ) const
+  {
+    return _times.capacity() * sizeof( double )
+      + (_heap.capacity() + _position.capacity()) * sizeof( unsigned int );
+  }
+};
+
+#endif
@@ -1,24 +1,37 @@
 #ifndef EXPONENTIAL_HH
 #define EXPONENTIAL_HH
 
-#include <random>
+#include <array>
 
 #include "random.hh"
 
+/* Samples are drawn from the PRNG a batch at a time and handed out
+   one by one. */
 class Exponential
 {
 private:
-  std::exponential_distribution<> distribution;
+  static const unsigned int batch_size = 64;
+
+  double _rate;
+  std::array< double, batch_size > _samples; /* with rate 1 */
+  unsigned int _next;
 
 public:
-  Exponential( const double & rate ) : distribution( rate ) {}
+  Exponential( const double & rate ) : _rate( rate ), _samples(), _next( batch_size ) {}
 
   void set_lambda( const double & rate ) 
   {
-  	distribution = std::exponential_distribution<> ( rate );
+  	_rate = rate;
   }
   
-  double sample( PRNG & prng ) { return distribution( prng ); }
+  double sample( PRNG & prng )
+  {
+    if ( _next == batch_size ) {
+      fill_exponential( prng, _samples.data(), batch_size );
+      _next = 0;
+    }
+    return _samples[ _next++ ] / _rate;
+  }
 };
 
 #endif
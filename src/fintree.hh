@@ -6,6 +6,7 @@
 #include "configrange.hh"
 #include "fin.hh"
 #include "memoryrange.hh"
+#include "usageledger.hh"
 #include "dna.pb.h"
 
 class FinTree {
@@ -15,20 +16,23 @@ private:
   std::vector< FinTree > _children;
   std::vector< Fin > _leaf;
 
-  const Fin * fin( const Memory & _memory ) const;
+  unsigned int apply_usage( const UsageLedger & usage, const unsigned int first_leaf );
+
+  template <class TreeType, class ActionType> friend class CompiledTree;
 
 public:
+  typedef Fin ActionType;
+
   FinTree();
 
   FinTree( const Fin & fin, const bool bisect );
 
-  const Fin & use_fin( const Memory & _memory, const bool track ) const;
-
   bool replace( const Fin & w );
   bool replace( const Fin & src, const FinTree & dst );
   const Fin * most_used( const unsigned int max_generation ) const;
 
-  void reset_counts( void );
+  /* set usage counts (and medians, if tracked) from an evaluation of this tree */
+  void apply_usage( const UsageLedger & usage );
   void promote( const unsigned int generation );
   void reset_generation( void );
 
@@ -14,7 +14,7 @@ void Fish::send( const unsigned int id, NextHop & next, const double & tickno )
 
   if ( _lambda == 0 ) {
     /* initial lambda  */
-    const Fin & current_fin( _fins.use_fin( _memory, _track ) );
+    const Fin & current_fin( _fins.get().use_action( _memory, _usage, _track ) );
     _update_lambda( current_fin.lambda() );
   }
 
@@ -5,8 +5,9 @@
 
 using namespace std;
 
-Fish::Fish( const FinTree & fins, const unsigned int s_prng_seed, const bool s_track )
+Fish::Fish( const CompiledFinTree & fins, UsageLedger & usage, const unsigned int s_prng_seed, const bool s_track )
   :  _fins( fins ),
+     _usage( usage ),
      _memory(),
      _packets_sent( 0 ),
      _packets_received( 0 ),
@@ -23,12 +24,12 @@ Fish::Fish( const FinTree & fins, const unsigned int s_prng_seed, const bool s_t
 {
 }
 
-void Fish::packets_received( const vector< Packet > & packets ) {
+void Fish::packets_received( const PacketSpan & packets ) {
     _packets_received += packets.size();
     _memory.packets_received( packets, _flow_id, _largest_ack );
-    _largest_ack = max( packets.at( packets.size() - 1 ).seq_num, _largest_ack );
+    _largest_ack = max( packets.back().seq_num, _largest_ack );
     
-    const Fin & current_fin( _fins.use_fin( _memory, _track ) );
+    const Fin & current_fin( _fins.get().use_action( _memory, _usage, _track ) );
     _update_lambda( current_fin.lambda() );
     _update_send_time( _last_send_time );
 }
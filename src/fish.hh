@@ -2,6 +2,7 @@
 #define FISH_HH
 
 #include <cassert>
+#include <functional>
 #include <vector>
 #include <string>
 
@@ -9,13 +10,14 @@
 #include "memory.hh"
 #include "random.hh"
 #include "exponential.hh"
-#include "fintree.hh"
+#include "compiledtree.hh"
 #include "simulationresults.pb.h"
 
 class Fish
 {
 private:
-  const FinTree & _fins;
+  std::reference_wrapper< const CompiledFinTree > _fins;
+  std::reference_wrapper< UsageLedger > _usage;
   Memory _memory;
 
   int _packets_sent, _packets_received;
@@ -37,18 +39,20 @@ private:
   void _update_lambda( const double lambda );
 
 public:
-  Fish( const FinTree & fins, const unsigned int s_prng_seed, const bool s_track );
+  Fish( const CompiledFinTree & fins, UsageLedger & usage, const unsigned int s_prng_seed, const bool s_track );
 
-  void packets_received( const std::vector< Packet > & packets );
+  void packets_received( const PacketSpan & packets );
   void reset( const double & tickno ); /* start new flow */
 
-  const FinTree & fins( void ) const { return _fins; }
-
   template <class NextHop>
   void send( const unsigned int id, NextHop & next, const double & tickno );
 
   Fish & operator=( const Fish & ) { assert( false ); return *this; }
 
+  /* use these rules and ledger from now on (for a copy that has to
+     outlive the originals) */
+  void rebind( const CompiledFinTree & fins, UsageLedger & usage ) { _fins = std::ref( fins ); _usage = std::ref( usage ); }
+
   double next_event_time( const double & tickno ) const;
 
   const int & packets_sent( void ) const { return _packets_sent; }
@@ -4,67 +4,85 @@
 
 using namespace std;
 
-Evaluator< FinTree >::Outcome FishBreeder::improve( FinTree & fins )
+Evaluator< FinTree >::Outcome FishBreeder::resume( FinTree & fins, BreederState< FinTree > & state )
 {
-  /* back up the original fintree */
-  /* this is to ensure we don't regress */
-  FinTree input_fintree( fins );
-
-  /* evaluate the fins we have */
-  fins.reset_generation();
-  unsigned int generation = 0;
-
-  while ( generation < 5 ) {
-    const Evaluator< FinTree > eval( _options.config_range );
-
-    auto outcome( eval.score( fins ) );
-
-    /* is there a fin at this generation that we can improve? */
-    auto most_used_fin_ptr = outcome.used_actions.most_used( generation );
-
-    /* if not, increase generation and promote all fins */
-    if ( !most_used_fin_ptr ) {
-      generation++;
-      fins.promote( generation );
+  state.restore_generations( fins );
+
+  while ( state.generation < 5 ) {
+    if ( state.action.empty() ) {
+      /* promoting doesn't change what the tree does, so after a promotion
+         the same seed is used again and the Evaluator remembers the outcome */
+      const Evaluator< FinTree > eval( state.keep_seed
+				       ? Evaluator< FinTree >( _options.config_range, state.prng_seed )
+				       : Evaluator< FinTree >( _options.config_range ) );
+
+      auto outcome( eval.score( fins ) );
+
+      /* is there a fin at this generation that we can improve? */
+      auto most_used_fin_ptr = outcome.used_actions.most_used( state.generation );
+
+      /* if not, increase generation and promote all fins */
+      if ( !most_used_fin_ptr ) {
+        state.generation++;
+        state.improved.clear();
+        fins.promote( state.generation );
+        state.prng_seed = eval.prng_seed();
+        state.keep_seed = true;
+        checkpoint( fins, state );
+
+        continue;
+      }
 
-      continue;
+      state.action.assign( 1, *most_used_fin_ptr );
+      state.prng_seed = eval.prng_seed();
+      state.keep_seed = false;
+      state.score_to_beat = outcome.score;
+      state.eval_cache.clear();
     }
 
-    FinImprover improver( eval, fins, outcome.score );
+    const Evaluator< FinTree > eval( _options.config_range, state.prng_seed );
+    FinImprover improver( eval, fins, state.score_to_beat, _options.racing );
+    improver.restore_eval_cache( state.eval_cache );
 
-    Fin fin_to_improve = *most_used_fin_ptr;
-
-    double score_to_beat = outcome.score;
+    Fin & fin_to_improve = state.action.front();
 
     while ( 1 ) {
       double new_score = improver.improve( fin_to_improve );
-      assert( new_score >= score_to_beat );
-      if ( new_score == score_to_beat ) {
+      assert( new_score >= state.score_to_beat );
+      if ( new_score == state.score_to_beat ) {
         cerr << "Ending search." << endl;
         break;
       } else {
-        cerr << "Score jumps from " << score_to_beat << " to " << new_score << endl;
-        score_to_beat = new_score;
+        cerr << "Score jumps from " << state.score_to_beat << " to " << new_score << endl;
+        state.score_to_beat = new_score;
+        state.eval_cache = improver.eval_cache();
+        checkpoint( fins, state );
       }
     }
 
-    fin_to_improve.demote( generation + 1 );
+    fin_to_improve.demote( state.generation + 1 );
 
     const auto result __attribute((unused)) = fins.replace( fin_to_improve );
     assert( result );
+
+    state.improved.push_back( fin_to_improve );
+    state.action.clear();
+    checkpoint( fins, state );
   }
 
   /* Split most used whisker */
-  apply_best_split( fins, generation );
+  apply_best_split( fins, state.generation );
 
-  /* carefully evaluate what we have vs. the previous best */
-  const Evaluator< FinTree > eval2( _options.config_range );
+  /* carefully evaluate what we have vs. the previous best, on networks
+     drawn afresh for this round; with a fixed careful seed they are
+     the last round's, so the previous best's score is remembered */
+  const Evaluator< FinTree > eval2( _options.config_range, careful_seed() );
   const auto new_score = eval2.score( fins, false, 10 );
-  const auto old_score = eval2.score( input_fintree, false, 10 );
+  const auto old_score = eval2.score( state.input_tree, false, 10 );
 
   if ( old_score.score >= new_score.score ) {
     fprintf( stderr, "Regression, old=%f, new=%f\n", old_score.score, new_score.score );
-    fins = input_fintree;
+    fins = state.input_tree;
     return old_score;
   }
 
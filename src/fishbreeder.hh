@@ -9,8 +9,9 @@ protected:
   std::vector< Fin > get_replacements( Fin & action_to_improve );
 
 public:
-  FinImprover( const Evaluator<  FinTree > & evaluator, const FinTree & fish, const double score_to_beat )
-    : ActionImprover< FinTree, Fin >( evaluator, fish, score_to_beat) {};
+  FinImprover( const Evaluator<  FinTree > & evaluator, const FinTree & fish, const double score_to_beat,
+               const RacingSchedule & racing )
+    : ActionImprover< FinTree, Fin >( evaluator, fish, score_to_beat, racing ) {};
 };
 
 class FishBreeder : public Breeder< FinTree >
@@ -18,7 +19,7 @@ class FishBreeder : public Breeder< FinTree >
 public:
   FishBreeder( const BreederOptions & s_options ) : Breeder( s_options ) {};
 
-  Evaluator< FinTree >::Outcome improve( FinTree & fins );
+  Evaluator< FinTree >::Outcome resume( FinTree & fins, BreederState< FinTree > & state );
 };
 
 #endif
@@ -1,25 +1,28 @@
 #ifndef LINK_HH
 #define LINK_HH
 
-#include <deque>
 #include <vector>
 
 #include "packet.hh"
 #include "delay.hh"
+#include "profile.hh"
+#include "ringbuffer.hh"
 
 class Link
 {
 private:
-  std::deque< Packet > _buffer;
+  RingBuffer< Packet > _buffer;
 
   Delay _pending_packet;
 
   unsigned int _limit;
 
+  uint64_t _packets_dropped; /* only counted when profiling */
+
 public:
   Link( const double s_rate,
 	const unsigned int s_limit )
-    : _buffer(), _pending_packet( 1.0 / s_rate ), _limit( s_limit ) {}
+    : _buffer(), _pending_packet( 1.0 / s_rate ), _limit( s_limit ), _packets_dropped( 0 ) {}
 
   void accept( const Packet & p, const double & tickno ) noexcept {
     if ( _pending_packet.empty() ) {
@@ -27,6 +30,8 @@ public:
     } else {
       if ( _limit and _buffer.size() < _limit ) {
         _buffer.push_back( p );
+      } else {
+        PROFILE( _packets_dropped++ );
       }
     }
   }
@@ -36,6 +41,9 @@ public:
 
   double next_event_time( const double & tickno ) const { return _pending_packet.next_event_time( tickno ); }
 
+  size_t queue_size( void ) const { return _buffer.size(); }
+  uint64_t packets_dropped( void ) const { return _packets_dropped; }
+
   std::vector<unsigned int> packets_in_flight( const unsigned int num_senders ) const
   {
     std::vector<unsigned int> ret( num_senders );
@@ -49,6 +57,9 @@ public:
     return ret;
   }
 
+  void reserve( const unsigned int n ) { _buffer.reserve( n ); }
+  size_t footprint( void ) const { return _buffer.footprint() + _pending_packet.footprint(); }
+
   void set_rate( const double rate ) { _pending_packet.set_delay( 1.0 / rate ); }
   double rate( void ) const { return 1.0 / _pending_packet.delay(); }
   void set_limit( const unsigned int limit )
@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <cassert>
+
+#include "mediansketch.hh"
+
+using namespace std;
+
+MedianSketch::MedianSketch()
+  : _centroids(),
+    _size( 0 ),
+    _count( 0 )
+{
+}
+
+void MedianSketch::add_centroid( const Memory::DataType mean, const unsigned int weight )
+{
+  if ( _size == capacity ) {
+    compress();
+  }
+
+  _centroids[ _size ].mean = mean;
+  _centroids[ _size ].weight = weight;
+  _size++;
+  _count += weight;
+}
+
+void MedianSketch::compress( void )
+{
+  sort( _centroids.begin(), _centroids.begin() + _size,
+	[] ( const Centroid & a, const Centroid & b ) { return a.mean < b.mean; } );
+
+  /* any two neighbours that survive weigh more than limit together,
+     which leaves at most capacity / 2 + 1 centroids */
+  const unsigned int limit = (4 * _count + capacity - 1) / capacity;
+
+  unsigned int out = 0;
+  for ( unsigned int i = 1; i < _size; i++ ) {
+    Centroid & current = _centroids[ out ];
+    const Centroid & next = _centroids[ i ];
+
+    if ( current.weight + next.weight <= limit ) {
+      const unsigned int weight = current.weight + next.weight;
+      current.mean = (current.mean * current.weight + next.mean * next.weight) / weight;
+      current.weight = weight;
+    } else {
+      _centroids[ ++out ] = next;
+    }
+  }
+
+  _size = out + 1;
+  assert( _size < capacity );
+}
+
+void MedianSketch::merge( const MedianSketch & other )
+{
+  for ( unsigned int i = 0; i < other._size; i++ ) {
+    add_centroid( other._centroids[ i ].mean, other._centroids[ i ].weight );
+  }
+}
+
+Memory::DataType MedianSketch::median( void ) const
+{
+  assert( _count > 0 );
+
+  array< Centroid, capacity > sorted( _centroids );
+  sort( sorted.begin(), sorted.begin() + _size,
+	[] ( const Centroid & a, const Centroid & b ) { return a.mean < b.mean; } );
+
+  /* treat each centroid as sitting at the middle of the ranks it covers,
+     and interpolate between the two around the middle rank */
+  const double target = _count / 2.0;
+  double previous_rank = sorted[ 0 ].weight / 2.0;
+  if ( target <= previous_rank ) {
+    return sorted[ 0 ].mean;
+  }
+
+  double cumulative = sorted[ 0 ].weight;
+  for ( unsigned int i = 1; i < _size; i++ ) {
+    const double rank = cumulative + sorted[ i ].weight / 2.0;
+    if ( target <= rank ) {
+      const double fraction = (target - previous_rank) / (rank - previous_rank);
+      return sorted[ i - 1 ].mean + fraction * (sorted[ i ].mean - sorted[ i - 1 ].mean);
+    }
+    previous_rank = rank;
+    cumulative += sorted[ i ].weight;
+  }
+
+  return sorted[ _size - 1 ].mean;
+}
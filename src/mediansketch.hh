@@ -0,0 +1,46 @@
+#ifndef MEDIANSKETCH_HH
+#define MEDIANSKETCH_HH
+
+#include <array>
+
+#include "memory.hh"
+
+/* Fixed-size streaming estimate of the median of one signal.
+
+   Samples are kept as weighted centroids; when the array fills up,
+   neighbouring centroids (in sorted order) are combined so that no
+   centroid holds more than about 4/capacity of the samples. Up to
+   capacity samples, the median is exact. Two sketches can be merged,
+   so every thread can keep its own and combine them afterwards. */
+class MedianSketch
+{
+public:
+  static const unsigned int capacity = 32;
+
+private:
+  struct Centroid
+  {
+    Memory::DataType mean;
+    unsigned int weight;
+  };
+
+  std::array< Centroid, capacity > _centroids;
+  unsigned int _size;
+  unsigned int _count;
+
+  void add_centroid( const Memory::DataType mean, const unsigned int weight );
+  void compress( void );
+
+public:
+  MedianSketch();
+
+  void add( const Memory::DataType x ) { add_centroid( x, 1 ); }
+  void merge( const MedianSketch & other );
+
+  unsigned int count( void ) const { return _count; }
+
+  /* must have at least one sample */
+  Memory::DataType median( void ) const;
+};
+
+#endif
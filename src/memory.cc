@@ -10,11 +10,11 @@ static const double alpha = 1.0 / 8.0;
 
 static const double slow_alpha = 1.0 / 256.0;
 
-void Memory::packets_received( const vector< Packet > & packets, const unsigned int flow_id,
+void Memory::packets_received( const PacketSpan & packets, const unsigned int flow_id,
   const int largest_ack )
 {
   for ( const auto &x : packets ) {
-    if ( x.flow_id != flow_id ) {
+    if ( not x.of_flow( flow_id ) ) {
       continue;
     }
 
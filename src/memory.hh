@@ -56,7 +56,7 @@ public:
   DataType & mutable_field( unsigned int num )     { return num == 0 ? _rec_send_ewma : num == 1 ? _rec_rec_ewma : num == 2 ? _rtt_ratio : num == 3 ? _slow_rec_rec_ewma : num == 4 ? _rtt_diff : _queueing_delay ; }
 
   void packet_sent( const Packet & packet __attribute((unused)) ) {}
-  void packets_received( const std::vector< Packet > & packets, const unsigned int flow_id, const int largest_ack );
+  void packets_received( const PacketSpan & packets, const unsigned int flow_id, const int largest_ack );
   void advance_to( const unsigned int tickno __attribute((unused)) ) {}
 
   std::string str( void ) const;
@@ -3,18 +3,20 @@
 #include "memoryrange.hh"
 
 using namespace std;
-using namespace boost::accumulators;
 
 std::vector< MemoryRange > MemoryRange::bisect( void ) const
 {
   vector< MemoryRange > ret { *this };
 
   /* bisect in each active axis */
-  for ( auto & i : _active_axis ) {
+  for ( unsigned int axis = 0; axis < _active_axis.size(); axis++ ) {
+      const Axis i = _active_axis[ axis ];
+      const bool has_median = axis < _medians.size() and _medians[ axis ].count() > 0;
+
       vector< MemoryRange > doubled;
       for ( const auto &x : ret ) {
       auto ersatz_lower( x._lower ), ersatz_upper( x._upper );
-      ersatz_lower.mutable_field( i ) = ersatz_upper.mutable_field( i ) = median( _acc[ i ] );
+      ersatz_lower.mutable_field( i ) = ersatz_upper.mutable_field( i ) = has_median ? _medians[ axis ].median() : x._lower.field( i );
 
       if ( x._lower == ersatz_upper ) {
 	/* try range midpoint instead */
@@ -57,14 +59,6 @@ bool MemoryRange::contains( const Memory & query ) const
   return true;
 }
 
-void MemoryRange::track( const Memory & query ) const
-{
-  /* log it */
-  for ( auto & i : _active_axis ) {
-    _acc[ i ]( query.field( i ) );
-  }
-}
-
 bool MemoryRange::operator==( const MemoryRange & other ) const
 {
   for ( auto & i : _active_axis ) {
@@ -105,7 +99,7 @@ MemoryRange::MemoryRange( const RemyBuffers::MemoryRange & dna )
   : _lower( true, dna.lower() ),
     _upper( false, dna.upper() ),
     _active_axis( ), 
-    _acc( Memory::datasize ),
+    _medians(),
     _count( 0 )
 {
   for (auto & x : dna.active_axis()) {
@@ -1,13 +1,11 @@
 #ifndef MEMORYRANGE_HH
 #define MEMORYRANGE_HH
 
-#include <boost/accumulators/accumulators.hpp>
-#include <boost/accumulators/statistics/stats.hpp>
-#include <boost/accumulators/statistics/median.hpp>
 #include <vector>
 #include <string>
 
 #include "memory.hh"
+#include "mediansketch.hh"
 #include "dna.pb.h"
 
 typedef RemyBuffers::MemoryRange::Axis Axis;
@@ -21,15 +19,15 @@ private:
      rec_send_ewma, rec_rec_ewma, rtt_ratio and slow_rec_rec_rewma. */
   std::vector< Axis > _active_axis;
 
-  mutable std::vector< boost::accumulators::accumulator_set< Memory::DataType,
-							     boost::accumulators::stats<
-							     boost::accumulators::tag::median > > > _acc;
-  mutable unsigned int _count;
+  /* usage statistics, filled in from a UsageLedger after an evaluation;
+     one median per active axis, or none if the evaluation wasn't traced */
+  std::vector< MedianSketch > _medians;
+  unsigned int _count;
 
 public:
   MemoryRange( const Memory & s_lower, const Memory & s_upper, 
     std::vector< Axis > s_active = { RemyBuffers::MemoryRange::SEND_EWMA, RemyBuffers::MemoryRange::REC_EWMA, RemyBuffers::MemoryRange::RTT_RATIO, RemyBuffers::MemoryRange::SLOW_REC_EWMA } )
-    : _lower( s_lower ), _upper( s_upper ), _active_axis( s_active ), _acc( Memory::datasize ), _count( 0 )
+    : _lower( s_lower ), _upper( s_upper ), _active_axis( s_active ), _medians(), _count( 0 )
   {}
 
   std::vector< MemoryRange > bisect( void ) const;
@@ -37,11 +35,13 @@ public:
 
   bool contains( const Memory & query ) const;
 
-  void use( void ) const { _count++; }
-  unsigned int count( void ) const { return _count; }
-  void reset_count( void ) const { _count = 0; }
+  const Memory & lower( void ) const { return _lower; }
+  const Memory & upper( void ) const { return _upper; }
+  const std::vector< Axis > & active_axis( void ) const { return _active_axis; }
 
-  void track( const Memory & query ) const;
+  unsigned int count( void ) const { return _count; }
+  void set_count( const unsigned int count ) { _count = count; }
+  void set_medians( const std::vector< MedianSketch > & medians ) { _medians = medians; }
 
   bool operator==( const MemoryRange & other ) const;
 
@@ -0,0 +1,224 @@
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "messagesocket.hh"
+
+using namespace std;
+
+/* anything bigger is a corrupt stream, not a message */
+static const uint32_t max_message_length = 1 << 28;
+
+static bool is_tcp( const string & address )
+{
+  return address.find( '/' ) == string::npos and address.find( ':' ) != string::npos;
+}
+
+static sockaddr_un unix_address( const string & path )
+{
+  sockaddr_un ret;
+  memset( &ret, 0, sizeof( ret ) );
+  ret.sun_family = AF_UNIX;
+  if ( path.size() >= sizeof( ret.sun_path ) ) {
+    fprintf( stderr, "Socket path too long: %s\n", path.c_str() );
+    exit( 1 );
+  }
+  strcpy( ret.sun_path, path.c_str() );
+  return ret;
+}
+
+static addrinfo * tcp_address( const string & address, const bool passive )
+{
+  const size_t colon = address.rfind( ':' );
+  const string host( address.substr( 0, colon ) ), port( address.substr( colon + 1 ) );
+
+  addrinfo hints;
+  memset( &hints, 0, sizeof( hints ) );
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = passive ? AI_PASSIVE : 0;
+
+  addrinfo * ret = nullptr;
+  const int error = getaddrinfo( host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &ret );
+  if ( error ) {
+    fprintf( stderr, "Could not resolve %s: %s\n", address.c_str(), gai_strerror( error ) );
+    return nullptr;
+  }
+  return ret;
+}
+
+int connect_socket( const string & address )
+{
+  if ( not is_tcp( address ) ) {
+    int fd = socket( AF_UNIX, SOCK_STREAM, 0 );
+    if ( fd < 0 ) {
+      return -1;
+    }
+
+    const sockaddr_un addr = unix_address( address );
+    if ( connect( fd, reinterpret_cast< const sockaddr * >( &addr ), sizeof( addr ) ) < 0 ) {
+      close( fd );
+      return -1;
+    }
+    return fd;
+  }
+
+  addrinfo * addresses = tcp_address( address, false );
+  int fd = -1;
+  for ( addrinfo * x = addresses; x and fd < 0; x = x->ai_next ) {
+    fd = socket( x->ai_family, x->ai_socktype, x->ai_protocol );
+    if ( fd >= 0 and connect( fd, x->ai_addr, x->ai_addrlen ) < 0 ) {
+      close( fd );
+      fd = -1;
+    }
+  }
+  if ( addresses ) {
+    freeaddrinfo( addresses );
+  }
+  return fd;
+}
+
+int listen_socket( const string & address )
+{
+  int fd = -1;
+
+  if ( not is_tcp( address ) ) {
+    fd = socket( AF_UNIX, SOCK_STREAM, 0 );
+    if ( fd < 0 ) {
+      perror( "socket" );
+      exit( 1 );
+    }
+
+    /* a socket file left behind by an earlier worker */
+    unlink( address.c_str() );
+
+    const sockaddr_un addr = unix_address( address );
+    if ( bind( fd, reinterpret_cast< const sockaddr * >( &addr ), sizeof( addr ) ) < 0 ) {
+      perror( "bind" );
+      exit( 1 );
+    }
+  } else {
+    addrinfo * addresses = tcp_address( address, true );
+    if ( not addresses ) {
+      exit( 1 );
+    }
+
+    fd = socket( addresses->ai_family, addresses->ai_socktype, addresses->ai_protocol );
+    if ( fd < 0 ) {
+      perror( "socket" );
+      exit( 1 );
+    }
+
+    const int reuse = 1;
+    if ( setsockopt( fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof( reuse ) ) < 0 ) {
+      perror( "setsockopt" );
+      exit( 1 );
+    }
+
+    if ( bind( fd, addresses->ai_addr, addresses->ai_addrlen ) < 0 ) {
+      perror( "bind" );
+      exit( 1 );
+    }
+    freeaddrinfo( addresses );
+  }
+
+  if ( listen( fd, 16 ) < 0 ) {
+    perror( "listen" );
+    exit( 1 );
+  }
+
+  return fd;
+}
+
+static bool write_all( const int fd, const char * data, size_t length )
+{
+  while ( length > 0 ) {
+    const ssize_t written = write( fd, data, length );
+    if ( written < 0 and errno == EINTR ) {
+      continue;
+    } else if ( written <= 0 ) {
+      return false;
+    }
+    data += written;
+    length -= written;
+  }
+  return true;
+}
+
+/* deadline is only used if wait is set */
+static bool read_all( const int fd, char * data, size_t length,
+		      const bool wait, const chrono::steady_clock::time_point & deadline )
+{
+  while ( length > 0 ) {
+    if ( wait ) {
+      const auto left = chrono::duration_cast< chrono::milliseconds >( deadline - chrono::steady_clock::now() );
+      pollfd readable { fd, POLLIN, 0 };
+      const int ready = left.count() > 0 ? poll( &readable, 1, left.count() ) : 0;
+      if ( ready < 0 and errno == EINTR ) {
+	continue;
+      } else if ( ready <= 0 ) {
+	return false;
+      }
+    }
+
+    const ssize_t got = read( fd, data, length );
+    if ( got < 0 and errno == EINTR ) {
+      continue;
+    } else if ( got <= 0 ) {
+      return false;
+    }
+    data += got;
+    length -= got;
+  }
+  return true;
+}
+
+bool send_message( const int fd, const google::protobuf::MessageLite & message )
+{
+  string frame( 4, '\0' );
+  if ( not message.AppendToString( &frame ) ) {
+    fprintf( stderr, "Could not serialize message.\n" );
+    exit( 1 );
+  }
+
+  const uint32_t length = frame.size() - 4;
+  for ( unsigned int i = 0; i < 4; i++ ) {
+    frame[ i ] = (length >> (24 - 8 * i)) & 0xff;
+  }
+
+  return write_all( fd, frame.data(), frame.size() );
+}
+
+bool receive_message( const int fd, google::protobuf::MessageLite & message,
+		      const int timeout_ms )
+{
+  const bool wait = timeout_ms >= 0;
+  const auto deadline = chrono::steady_clock::now() + chrono::milliseconds( wait ? timeout_ms : 0 );
+
+  unsigned char header[ 4 ];
+  if ( not read_all( fd, reinterpret_cast< char * >( header ), 4, wait, deadline ) ) {
+    return false;
+  }
+
+  const uint32_t length = (uint32_t( header[ 0 ] ) << 24) | (header[ 1 ] << 16)
+    | (header[ 2 ] << 8) | header[ 3 ];
+  if ( length > max_message_length ) {
+    fprintf( stderr, "Ignoring a message of %u bytes.\n", length );
+    return false;
+  }
+
+  string body( length, '\0' );
+  if ( not read_all( fd, &body[ 0 ], length, wait, deadline ) ) {
+    return false;
+  }
+
+  return message.ParseFromString( body );
+}
@@ -0,0 +1,24 @@
+#ifndef MESSAGESOCKET_HH
+#define MESSAGESOCKET_HH
+
+#include <string>
+#include <google/protobuf/message_lite.h>
+
+/* Protobuf messages over a stream (socket or pipe), each framed by its
+   length as a four-byte big-endian integer. Addresses are either
+   HOST:PORT for TCP or a filesystem path for a Unix socket. */
+
+/* returns -1 (with errno set) if the connection fails */
+int connect_socket( const std::string & address );
+
+/* exits if the address can't be bound */
+int listen_socket( const std::string & address );
+
+/* both return false if the stream failed or was closed; receiving
+   also fails if the whole message hasn't come within timeout_ms
+   (if given) */
+bool send_message( const int fd, const google::protobuf::MessageLite & message );
+bool receive_message( const int fd, google::protobuf::MessageLite & message,
+		      const int timeout_ms = -1 );
+
+#endif
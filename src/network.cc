@@ -1,3 +1,5 @@
+#include <cmath>
+
 #include "network.hh"
 #include "simulationresults.hh"
 #include "sendergangofgangs.cc"
@@ -8,39 +10,91 @@ Network<Gang1Type, Gang2Type>::Network( const typename Gang1Type::Sender & examp
 					const typename Gang2Type::Sender & example_sender2,
 					PRNG & s_prng,
 					const NetConfig & config )
-  : _prng( s_prng ),
-    _senders( Gang1Type( config.mean_on_duration, config.mean_off_duration, config.num_senders, example_sender1, _prng ),
-	      Gang2Type( config.mean_on_duration, config.mean_off_duration, config.num_senders, example_sender2, _prng, config.num_senders ) ),
+  : _senders( Gang1Type( config.mean_on_duration, config.mean_off_duration, config.num_senders, example_sender1, s_prng ),
+	      Gang2Type( config.mean_on_duration, config.mean_off_duration, config.num_senders, example_sender2, s_prng, config.num_senders ) ),
     _link( config.link_ppt, config.buffer_size ),
     _delay( config.delay ),
-    _rec(),
+    _rec( 2 * config.num_senders ), /* the second gang's ids follow the first's */
     _tickno( 0 ),
-    _stochastic_loss( config.stochastic_loss_rate , _prng)
+    _stochastic_loss( config.stochastic_loss_rate , s_prng),
+    _profile()
 {
+  reserve_queues( config );
 }
 
 template <class Gang1Type, class Gang2Type>
 Network<Gang1Type, Gang2Type>::Network( const typename Gang1Type::Sender & example_sender1,
 					PRNG & s_prng,
 					const NetConfig & config )
-  : _prng( s_prng ),
-    _senders( Gang1Type( config.mean_on_duration, config.mean_off_duration, config.num_senders, example_sender1, _prng ),
+  : _senders( Gang1Type( config.mean_on_duration, config.mean_off_duration, config.num_senders, example_sender1, s_prng ),
 	      Gang2Type() ),
     _link( config.link_ppt, config.buffer_size ),
     _delay( config.delay ),
-    _rec(),
+    _rec( config.num_senders ),
     _tickno( 0 ),
-    _stochastic_loss( config.stochastic_loss_rate , _prng)
+    _stochastic_loss( config.stochastic_loss_rate , s_prng),
+    _profile()
+{
+  reserve_queues( config );
+}
+
+template <class Gang1Type, class Gang2Type>
+void Network<Gang1Type, Gang2Type>::reserve_queues( const NetConfig & config )
 {
+  /* the bottleneck queue holds up to a buffer's worth (or, if the
+     buffer is unlimited, about a bandwidth-delay product), and the
+     propagation delay about a bandwidth-delay product; the queues
+     still grow past these if they have to */
+  const double max_reserved = 1 << 16;
+  const double bdp = min( max_reserved, ceil( config.link_ppt * config.delay ) + 1 );
+  _link.reserve( min( bdp, config.buffer_size ) );
+  _delay.reserve( bdp );
 }
 
 template <class Gang1Type, class Gang2Type>
 void Network<Gang1Type, Gang2Type>::tick( void )
 {
+#ifdef REMY_PROFILING
+  /* note which components have an event due, and time each one */
+  _profile.ticks++;
+  _profile.events[ SimulationProfile::SENDERS ] += _senders.next_event_time( _tickno ) <= _tickno;
+  _profile.events[ SimulationProfile::LINK ] += _link.next_event_time( _tickno ) <= _tickno;
+  _profile.events[ SimulationProfile::STOCHASTIC_LOSS ] += _stochastic_loss.next_event_time( _tickno ) <= _tickno;
+  _profile.events[ SimulationProfile::DELAY ] += _delay.next_event_time( _tickno ) <= _tickno;
+  _profile.events[ SimulationProfile::RECEIVER ] += _rec.next_event_time( _tickno ) <= _tickno;
+
+  auto start = chrono::steady_clock::now();
+  auto lap = [&] ( const SimulationProfile::Component component ) {
+    const auto now = chrono::steady_clock::now();
+    _profile.seconds[ component ] += chrono::duration< double >( now - start ).count();
+    start = now;
+  };
+
   _senders.tick( _link, _rec, _tickno );
+  lap( SimulationProfile::SENDERS );
   _link.tick( _stochastic_loss, _tickno );
+  lap( SimulationProfile::LINK );
   _stochastic_loss.tick( _delay, _tickno );
+  lap( SimulationProfile::STOCHASTIC_LOSS );
   _delay.tick( _rec, _tickno );
+  lap( SimulationProfile::DELAY );
+
+  _profile.link_queue_high_water = max< uint64_t >( _profile.link_queue_high_water, _link.queue_size() );
+  _profile.delay_queue_high_water = max< uint64_t >( _profile.delay_queue_high_water, _delay.size() );
+#else
+  _senders.tick( _link, _rec, _tickno );
+  _link.tick( _stochastic_loss, _tickno );
+  _stochastic_loss.tick( _delay, _tickno );
+  _delay.tick( _rec, _tickno );
+#endif
+}
+
+template <class Gang1Type, class Gang2Type>
+SimulationProfile Network<Gang1Type, Gang2Type>::profile( void ) const
+{
+  SimulationProfile ret( _profile );
+  ret.link_drops = _link.packets_dropped();
+  return ret;
 }
 
 template <class Gang1Type, class Gang2Type>
@@ -48,7 +102,21 @@ void Network<Gang1Type, Gang2Type>::run_simulation( const double & duration )
 {
   assert( _tickno == 0 );
 
+  PROFILE( _profile.start_run() );
+
+  run_simulation_events( duration, std::numeric_limits<uint64_t>::max() );
+
+  PROFILE( _profile.end_run() );
+}
+
+template <class Gang1Type, class Gang2Type>
+bool Network<Gang1Type, Gang2Type>::run_simulation_events( const double & duration, uint64_t max_events )
+{
   while ( _tickno < duration ) {
+    if ( max_events-- == 0 ) {
+      return false;
+    }
+
     /* find element with soonest event */
     _tickno = min( min( _senders.next_event_time( _tickno ),
 			min(_link.next_event_time( _tickno ), _stochastic_loss.next_event_time( _tickno)) ),
@@ -60,6 +128,8 @@ void Network<Gang1Type, Gang2Type>::run_simulation( const double & duration )
 
     tick();
   }
+
+  return true;
 }
 
 template <class Gang1Type, class Gang2Type>
@@ -69,6 +139,8 @@ void Network<Gang1Type, Gang2Type>::run_simulation_until( const double tick_limi
     return;
   }
 
+  PROFILE( _profile.start_run() );
+
   while ( true ) {
     /* find element with soonest event */
     double next_tickno = min( min( _senders.next_event_time( _tickno ),
@@ -87,6 +159,8 @@ void Network<Gang1Type, Gang2Type>::run_simulation_until( const double tick_limi
 
     tick();
   }
+
+  PROFILE( _profile.end_run() );
 }
 
 template <class Gang1Type, class Gang2Type>
@@ -100,6 +174,8 @@ void Network<Gang1Type, Gang2Type>::run_simulation_with_logging_until( const dou
 
   double next_log_time = interval;
 
+  PROFILE( _profile.start_run() );
+
   while ( true ) {
     /* find element with soonest event */
     double next_tickno = min( min( _senders.next_event_time( _tickno ),
@@ -125,6 +201,8 @@ void Network<Gang1Type, Gang2Type>::run_simulation_with_logging_until( const dou
     }
 
   }
+
+  PROFILE( _profile.end_run() );
 }
 
 template <class Gang1Type, class Gang2Type>
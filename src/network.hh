@@ -9,6 +9,7 @@
 #include "stochastic-loss.hh"
 #include "receiver.hh"
 #include "random.hh"
+#include "profile.hh"
 #include "answer.pb.h"
 
 class SimulationRunData; // from simulationresults.hh
@@ -77,7 +78,6 @@ template <class Gang1Type, class Gang2Type>
 class Network
 {
 private:
-  PRNG & _prng;
   SenderGangofGangs<Gang1Type, Gang2Type> _senders;
   Link _link;
   Delay _delay;
@@ -85,8 +85,13 @@ private:
 
   double _tickno;
   StochasticLoss _stochastic_loss;
+
+  SimulationProfile _profile;
+
   void tick( void );
 
+  void reserve_queues( const NetConfig & config );
+
 public:
   Network( const typename Gang1Type::Sender & example_sender1, const typename Gang2Type::Sender & example_sender2, PRNG & s_prng, const NetConfig & config );
 
@@ -94,10 +99,24 @@ public:
 
   void run_simulation( const double & duration );
 
+  /* carries run_simulation( duration ) on for at most max_events
+     events; returns whether it is finished */
+  bool run_simulation_events( const double & duration, uint64_t max_events );
+
   void run_simulation_with_logging_until( const double tick_limit, SimulationRunData &, const double interval );
 
   void run_simulation_until( const double tick_limit );
 
+  /* have a copy draw from prng, and its senders use the given rules
+     and ledger, instead of the original's; the copy can then be run
+     on after they are gone */
+  template <typename... Args>
+  void rebind( PRNG & prng, Args &... args )
+  {
+    _senders.rebind( prng, args... );
+    _stochastic_loss.rebind( prng );
+  }
+
   const SenderGangofGangs<Gang1Type, Gang2Type> & senders( void ) const { return _senders; }
 
   SenderGangofGangs<Gang1Type, Gang2Type> & mutable_senders( void ) { return _senders; }
@@ -106,6 +125,16 @@ public:
 
   const double & tickno( void ) const { return _tickno; }
 
+  /* bytes taken up by this network, its queues and senders included */
+  size_t footprint( void ) const
+  {
+    return sizeof( *this ) + _senders.footprint() + _link.footprint() + _delay.footprint()
+      + _rec.footprint() + _stochastic_loss.footprint();
+  }
+
+  /* all zero unless built with --enable-profiling */
+  SimulationProfile profile( void ) const;
+
   Link & mutable_link( void ) { return _link; }
 
   Delay & mutable_delay( void ) { return _delay; }
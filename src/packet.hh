@@ -1,23 +1,58 @@
 #ifndef PACKET_HH
 #define PACKET_HH
 
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+/* 24 bytes, since packets are copied through every hop's queue: the
+   sender id is limited to 16 bits, and only the low 16 bits of the
+   flow id are kept (enough to tell the current flow's packets from
+   those of the few flows before it that may still be in flight) */
 class Packet
 {
 public:
-  unsigned int src;
-  unsigned int flow_id;
   double tick_sent, tick_received;
   int seq_num;
+  uint16_t src;
+  uint16_t flow_tag;
+
+  /* how many senders the src field can tell apart */
+  static const unsigned int max_senders = 65536;
 
   Packet( const unsigned int & s_src,
 	  const unsigned int & s_flow_id,
 	  const double & s_tick_sent,
 	  const int & s_seq_num )
-    : src( s_src ),
-      flow_id( s_flow_id ), tick_sent( s_tick_sent ),
+    : tick_sent( s_tick_sent ),
       tick_received( -1 ),
-      seq_num( s_seq_num )
-  {}
+      seq_num( s_seq_num ),
+      src( s_src ),
+      flow_tag( s_flow_id )
+  {
+    assert( src == s_src );
+  }
+
+  bool of_flow( const unsigned int flow_id ) const { return flow_tag == uint16_t( flow_id ); }
+};
+
+static_assert( sizeof( Packet ) == 24, "Packet should stay compact" );
+
+/* packets delivered together, viewed in place (not owned) */
+class PacketSpan
+{
+private:
+  const Packet * _begin;
+  size_t _size;
+
+public:
+  PacketSpan( const Packet * s_begin, const size_t s_size ) : _begin( s_begin ), _size( s_size ) {}
+
+  const Packet * begin( void ) const { return _begin; }
+  const Packet * end( void ) const { return _begin + _size; }
+  size_t size( void ) const { return _size; }
+  bool empty( void ) const { return _size == 0; }
+  const Packet & back( void ) const { assert( _size ); return _begin[ _size - 1 ]; }
 };
 
 #endif
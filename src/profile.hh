@@ -0,0 +1,93 @@
+#ifndef PROFILE_HH
+#define PROFILE_HH
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+/* Counts of where a simulation's events and time go, for finding the
+   configs that are slow to simulate. They are only kept in builds
+   configured with --enable-profiling, which defines REMY_PROFILING;
+   otherwise PROFILE( ... ) expands to nothing and they stay zero. */
+#ifdef REMY_PROFILING
+#define PROFILE( statement ) do { statement; } while ( 0 )
+#else
+#define PROFILE( statement ) do { } while ( 0 )
+#endif
+
+class SimulationProfile
+{
+private:
+  std::chrono::steady_clock::time_point _run_start;
+
+public:
+#ifdef REMY_PROFILING
+  static const bool enabled = true;
+#else
+  static const bool enabled = false;
+#endif
+
+  enum Component { SENDERS, LINK, STOCHASTIC_LOSS, DELAY, RECEIVER, NUM_COMPONENTS };
+
+  uint64_t ticks; /* times Network advanced to the next event */
+  uint64_t events[ NUM_COMPONENTS ]; /* ticks at which each component had an event due */
+  double seconds[ NUM_COMPONENTS ]; /* wall time spent in each component's tick */
+  double wall_seconds; /* wall time spent running the simulation */
+
+  uint64_t action_lookups;
+  uint64_t link_drops;
+  uint64_t link_queue_high_water;
+  uint64_t delay_queue_high_water;
+
+  SimulationProfile()
+    : _run_start(), ticks( 0 ), events(), seconds(), wall_seconds( 0 ),
+      action_lookups( 0 ), link_drops( 0 ),
+      link_queue_high_water( 0 ), delay_queue_high_water( 0 )
+  {}
+
+  void start_run( void ) { _run_start = std::chrono::steady_clock::now(); }
+  void end_run( void ) { wall_seconds += seconds_since( _run_start ); }
+
+  static double seconds_since( const std::chrono::steady_clock::time_point & start )
+  {
+    return std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+  }
+
+  void merge( const SimulationProfile & other )
+  {
+    ticks += other.ticks;
+    for ( unsigned int i = 0; i < NUM_COMPONENTS; i++ ) {
+      events[ i ] += other.events[ i ];
+      seconds[ i ] += other.seconds[ i ];
+    }
+    wall_seconds += other.wall_seconds;
+    action_lookups += other.action_lookups;
+    link_drops += other.link_drops;
+    link_queue_high_water = std::max( link_queue_high_water, other.link_queue_high_water );
+    delay_queue_high_water = std::max( delay_queue_high_water, other.delay_queue_high_water );
+  }
+
+  std::string str( void ) const
+  {
+    static const char * const names[ NUM_COMPONENTS ] = { "senders", "link", "loss", "delay", "receiver" };
+
+    char line[ 256 ];
+    snprintf( line, sizeof( line ), "%lu ticks in %.3f s (%.0f ticks/s), %lu action lookups, %lu link drops, queue high-water link=%lu delay=%lu\n",
+	      (unsigned long) ticks, wall_seconds, wall_seconds > 0 ? ticks / wall_seconds : 0.0,
+	      (unsigned long) action_lookups, (unsigned long) link_drops,
+	      (unsigned long) link_queue_high_water, (unsigned long) delay_queue_high_water );
+    std::string ret( line );
+
+    for ( unsigned int i = 0; i < NUM_COMPONENTS; i++ ) {
+      snprintf( line, sizeof( line ), "  %s: %lu events, %.3f s\n",
+		names[ i ], (unsigned long) events[ i ], seconds[ i ] );
+      ret += line;
+    }
+
+    return ret;
+  }
+};
+
+#endif
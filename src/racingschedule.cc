@@ -0,0 +1,82 @@
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+#include "racingschedule.hh"
+
+using namespace std;
+
+RacingStage::RacingStage( const RemyBuffers::RacingStage & dna )
+  : carefulness( dna.carefulness() ),
+    config_fraction( dna.config_fraction() ),
+    keep_fraction( dna.keep_fraction() )
+{
+}
+
+RemyBuffers::RacingStage RacingStage::DNA( void ) const
+{
+  RemyBuffers::RacingStage ret;
+  ret.set_carefulness( carefulness );
+  ret.set_config_fraction( config_fraction );
+  ret.set_keep_fraction( keep_fraction );
+  return ret;
+}
+
+RacingSchedule::RacingSchedule( void )
+  : stages( { RacingStage( 0.1, 1, 0.5 ) } ),
+    confidence( 2 )
+{
+}
+
+RacingSchedule::RacingSchedule( const RemyBuffers::RacingSchedule & dna )
+  : stages(),
+    confidence( dna.confidence() )
+{
+  for ( const auto & x : dna.stage() ) {
+    stages.emplace_back( x );
+  }
+}
+
+RemyBuffers::RacingSchedule RacingSchedule::DNA( void ) const
+{
+  RemyBuffers::RacingSchedule ret;
+  for ( const auto & x : stages ) {
+    ret.add_stage()->CopyFrom( x.DNA() );
+  }
+  ret.set_confidence( confidence );
+  return ret;
+}
+
+RacingSchedule RacingSchedule::parse( const string & stages )
+{
+  RacingSchedule ret;
+  ret.stages.clear();
+
+  istringstream input( stages );
+  string stage;
+  while ( getline( input, stage, ',' ) ) {
+    double carefulness, config_fraction, keep_fraction;
+    char trailing;
+    if ( sscanf( stage.c_str(), "%lf/%lf/%lf%c", &carefulness, &config_fraction, &keep_fraction, &trailing ) != 3
+	 or carefulness <= 0 or carefulness > 1
+	 or config_fraction <= 0 or config_fraction > 1
+	 or keep_fraction <= 0 or keep_fraction > 1 ) {
+      fprintf( stderr, "Invalid racing stage: \"%s\" (expected ticks/configs/keep, each in (0, 1])\n", stage.c_str() );
+      exit( 1 );
+    }
+    ret.stages.emplace_back( carefulness, config_fraction, keep_fraction );
+  }
+
+  return ret;
+}
+
+string RacingSchedule::str( void ) const
+{
+  ostringstream ret;
+  for ( const auto & x : stages ) {
+    ret << "[ticks=" << x.carefulness << ", configs=" << x.config_fraction
+	<< ", keep=" << x.keep_fraction << "] ";
+  }
+  ret << "confidence=" << confidence;
+  return ret.str();
+}
@@ -0,0 +1,49 @@
+#ifndef RACING_SCHEDULE_HH
+#define RACING_SCHEDULE_HH
+
+#include <string>
+#include <vector>
+
+#include "dna.pb.h"
+
+/* One round of cheap evaluations used to discard poor candidates
+   before they are scored in full. */
+class RacingStage
+{
+public:
+  double carefulness;     /* fraction of the simulation ticks */
+  double config_fraction; /* fraction of the NetConfigs */
+  double keep_fraction;   /* fraction of the candidates to keep */
+
+  RacingStage( const double s_carefulness, const double s_config_fraction, const double s_keep_fraction )
+    : carefulness( s_carefulness ),
+      config_fraction( s_config_fraction ),
+      keep_fraction( s_keep_fraction )
+  {}
+
+  RacingStage( const RemyBuffers::RacingStage & dna );
+  RemyBuffers::RacingStage DNA( void ) const;
+};
+
+/* Successive-halving schedule for ActionImprover. A candidate survives
+   a stage if its score is within confidence standard errors (from the
+   spread across the sampled configs) of the keep_fraction quantile. */
+class RacingSchedule
+{
+public:
+  std::vector< RacingStage > stages;
+  double confidence;
+
+  /* one stage at 10% of the ticks on every config, keeping half */
+  RacingSchedule( void );
+  RacingSchedule( const RemyBuffers::RacingSchedule & dna );
+  RemyBuffers::RacingSchedule DNA( void ) const;
+
+  /* stages as "carefulness/config_fraction/keep_fraction,...", with
+     the default confidence */
+  static RacingSchedule parse( const std::string & stages );
+
+  std::string str( void ) const;
+};
+
+#endif  // RACING_SCHEDULE_HH
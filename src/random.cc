@@ -1,11 +1,85 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
 #include <ctime>
+#include <sstream>
 #include <sys/types.h>
 #include <unistd.h>
 
 #include "random.hh"
 
+using namespace std;
+
+void Xoshiro256::seed( uint64_t seed )
+{
+  for ( auto & x : _state ) {
+    uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    x = z ^ (z >> 31);
+  }
+}
+
+ostream & operator<<( ostream & out, const Xoshiro256 & prng )
+{
+  return out << prng._state[ 0 ] << " " << prng._state[ 1 ] << " "
+	     << prng._state[ 2 ] << " " << prng._state[ 3 ];
+}
+
+istream & operator>>( istream & in, Xoshiro256 & prng )
+{
+  return in >> prng._state[ 0 ] >> prng._state[ 1 ] >> prng._state[ 2 ] >> prng._state[ 3 ];
+}
+
+void fill_exponential( PRNG & prng, double * out, const size_t n )
+{
+  /* draw first, then transform in a separate loop the compiler can
+     vectorize */
+  for ( size_t i = 0; i < n; i++ ) {
+    out[ i ] = prng.uniform();
+  }
+
+  for ( size_t i = 0; i < n; i++ ) {
+    out[ i ] = -log1p( -out[ i ] );
+  }
+}
+
+uint64_t bernoulli_bits( PRNG & prng, const double p )
+{
+  if ( p <= 0 ) {
+    return 0;
+  } else if ( p >= 1 ) {
+    return ~uint64_t( 0 );
+  }
+
+  /* compare whole draws against p scaled to 2^64 */
+  const uint64_t threshold = p * 18446744073709551616.0;
+  uint64_t ret = 0;
+  for ( int i = 0; i < 64; i++ ) {
+    ret |= uint64_t( prng() < threshold ) << i;
+  }
+  return ret;
+}
+
 PRNG & global_PRNG( void )
 {
   static PRNG generator( time( NULL ) ^ getpid() );
   return generator;
 }
+
+string global_PRNG_state( void )
+{
+  ostringstream state;
+  state << global_PRNG();
+  return state.str();
+}
+
+void restore_global_PRNG_state( const string & state )
+{
+  istringstream input( state );
+  input >> global_PRNG();
+  if ( input.fail() ) {
+    fprintf( stderr, "Could not restore PRNG state \"%s\".\n", state.c_str() );
+    exit( 1 );
+  }
+}
@@ -1,10 +1,68 @@
 #ifndef RANDOM_HH
 #define RANDOM_HH
 
-#include <random>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
 
-typedef std::default_random_engine PRNG;
+/* xoshiro256** (Blackman and Vigna): a few cycles per draw, with 256
+   bits of state */
+class Xoshiro256
+{
+private:
+  uint64_t _state[ 4 ];
+
+  static uint64_t rotl( const uint64_t x, const int k ) { return (x << k) | (x >> (64 - k)); }
+
+public:
+  typedef uint64_t result_type;
+
+  static constexpr result_type min( void ) { return 0; }
+  static constexpr result_type max( void ) { return ~result_type( 0 ); }
+
+  explicit Xoshiro256( const uint64_t seed = 1 ) : _state() { this->seed( seed ); }
+
+  /* expands the seed with splitmix64, so that nearby seeds give
+     unrelated streams */
+  void seed( uint64_t seed );
+
+  result_type operator()( void )
+  {
+    const uint64_t result = rotl( _state[ 1 ] * 5, 7 ) * 9;
+    const uint64_t t = _state[ 1 ] << 17;
+
+    _state[ 2 ] ^= _state[ 0 ];
+    _state[ 3 ] ^= _state[ 1 ];
+    _state[ 1 ] ^= _state[ 2 ];
+    _state[ 0 ] ^= _state[ 3 ];
+    _state[ 2 ] ^= t;
+    _state[ 3 ] = rotl( _state[ 3 ], 45 );
+
+    return result;
+  }
+
+  /* uniform on [0, 1), with 53 random bits */
+  double uniform( void ) { return ((*this)() >> 11) * (1.0 / 9007199254740992.0); }
+
+  friend std::ostream & operator<<( std::ostream & out, const Xoshiro256 & prng );
+  friend std::istream & operator>>( std::istream & in, Xoshiro256 & prng );
+};
+
+/* the simulator's generator; another can be plugged in here if it
+   provides uniform() (used by the batch samplers below) */
+typedef Xoshiro256 PRNG;
 
 extern PRNG & global_PRNG();
 
+/* save and restore the state of global_PRNG(), e.g. in a checkpoint */
+extern std::string global_PRNG_state( void );
+extern void restore_global_PRNG_state( const std::string & state );
+
+/* n samples of the exponential distribution with rate 1 */
+void fill_exponential( PRNG & prng, double * out, const size_t n );
+
+/* 64 Bernoulli trials, bit i set with probability p */
+uint64_t bernoulli_bits( PRNG & prng, const double p );
+
 #endif
@@ -13,7 +13,7 @@ void Rat::send( const unsigned int id, NextHop & next, const double & tickno,
 
   if ( _the_window == 0 ) {
     /* initial window and intersend time */
-    const Whisker & current_whisker( _whiskers.use_whisker( _memory, _track ) );
+    const Whisker & current_whisker( _whiskers.get().use_action( _memory, _usage, _track ) );
     _the_window = current_whisker.window( _the_window );
     _intersend_time = current_whisker.intersend();
   }
@@ -5,8 +5,9 @@
 
 using namespace std;
 
-Rat::Rat( WhiskerTree & s_whiskers, const bool s_track )
+Rat::Rat( const CompiledWhiskerTree & s_whiskers, UsageLedger & s_usage, const bool s_track )
   :  _whiskers( s_whiskers ),
+     _usage( s_usage ),
      _memory(),
      _packets_sent( 0 ),
      _packets_received( 0 ),
@@ -19,13 +20,13 @@ Rat::Rat( WhiskerTree & s_whiskers, const bool s_track )
 {
 }
 
-void Rat::packets_received( const vector< Packet > & packets ) {
+void Rat::packets_received( const PacketSpan & packets ) {
   _packets_received += packets.size();
   /* Assumption: There is no reordering */
   _memory.packets_received( packets, _flow_id, _largest_ack );
-  _largest_ack = max( packets.at( packets.size() - 1 ).seq_num, _largest_ack );
+  _largest_ack = max( packets.back().seq_num, _largest_ack );
 
-  const Whisker & current_whisker( _whiskers.use_whisker( _memory, _track ) );
+  const Whisker & current_whisker( _whiskers.get().use_action( _memory, _usage, _track ) );
 
   _the_window = current_whisker.window( _the_window );
   _intersend_time = current_whisker.intersend();
@@ -42,7 +43,7 @@ void Rat::reset( const double & )
   assert( _flow_id != 0 );
 
   /* initial window and intersend time */
-  const Whisker & current_whisker( _whiskers.use_whisker( _memory, _track ) );
+  const Whisker & current_whisker( _whiskers.get().use_action( _memory, _usage, _track ) );
   _the_window = current_whisker.window( _the_window );
   _intersend_time = current_whisker.intersend();
 }
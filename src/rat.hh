@@ -1,19 +1,21 @@
 #ifndef RAT_HH
 #define RAT_HH
 
+#include <functional>
 #include <vector>
 #include <string>
 #include <limits>
 
 #include "packet.hh"
-#include "whiskertree.hh"
+#include "compiledtree.hh"
 #include "memory.hh"
 #include "simulationresults.pb.h"
 
 class Rat
 {
 private:
-  const WhiskerTree & _whiskers;
+  std::reference_wrapper< const CompiledWhiskerTree > _whiskers;
+  std::reference_wrapper< UsageLedger > _usage;
   Memory _memory;
 
   unsigned int _packets_sent, _packets_received;
@@ -29,19 +31,21 @@ private:
   int _largest_ack;
 
 public:
-  Rat( WhiskerTree & s_whiskers, const bool s_track=false );
+  Rat( const CompiledWhiskerTree & s_whiskers, UsageLedger & s_usage, const bool s_track=false );
 
-  void packets_received( const std::vector< Packet > & packets );
+  void packets_received( const PacketSpan & packets );
   void reset( const double & tickno ); /* start new flow */
 
   template <class NextHop>
   void send( const unsigned int id, NextHop & next, const double & tickno,
 	     const unsigned int packets_sent_cap = std::numeric_limits<unsigned int>::max() );
 
-  const WhiskerTree & whiskers( void ) const { return _whiskers; }
-
   Rat & operator=( const Rat & ) { assert( false ); return *this; }
 
+  /* use these rules and ledger from now on (for a copy that has to
+     outlive the originals) */
+  void rebind( const CompiledWhiskerTree & whiskers, UsageLedger & usage ) { _whiskers = std::ref( whiskers ); _usage = std::ref( usage ); }
+
   double next_event_time( const double & tickno ) const;
 
   const unsigned int & packets_sent( void ) const { return _packets_sent; }
@@ -4,67 +4,85 @@
 
 using namespace std;
 
-Evaluator< WhiskerTree >::Outcome RatBreeder::improve( WhiskerTree & whiskers )
+Evaluator< WhiskerTree >::Outcome RatBreeder::resume( WhiskerTree & whiskers, BreederState< WhiskerTree > & state )
 {
-  /* back up the original whiskertree */
-  /* this is to ensure we don't regress */
-  WhiskerTree input_whiskertree( whiskers );
-
-  /* evaluate the whiskers we have */
-  whiskers.reset_generation();
-  unsigned int generation = 0;
-
-  while ( generation < 5 ) {
-    const Evaluator< WhiskerTree > eval( _options.config_range );
-
-    auto outcome( eval.score( whiskers ) );
-
-    /* is there a whisker at this generation that we can improve? */
-    auto most_used_whisker_ptr = outcome.used_actions.most_used( generation );
-
-    /* if not, increase generation and promote all whiskers */
-    if ( !most_used_whisker_ptr ) {
-      generation++;
-      whiskers.promote( generation );
+  state.restore_generations( whiskers );
+
+  while ( state.generation < 5 ) {
+    if ( state.action.empty() ) {
+      /* promoting doesn't change what the tree does, so after a promotion
+         the same seed is used again and the Evaluator remembers the outcome */
+      const Evaluator< WhiskerTree > eval( state.keep_seed
+				       ? Evaluator< WhiskerTree >( _options.config_range, state.prng_seed )
+				       : Evaluator< WhiskerTree >( _options.config_range ) );
+
+      auto outcome( eval.score( whiskers ) );
+
+      /* is there a whisker at this generation that we can improve? */
+      auto most_used_whisker_ptr = outcome.used_actions.most_used( state.generation );
+
+      /* if not, increase generation and promote all whiskers */
+      if ( !most_used_whisker_ptr ) {
+        state.generation++;
+        state.improved.clear();
+        whiskers.promote( state.generation );
+        state.prng_seed = eval.prng_seed();
+        state.keep_seed = true;
+        checkpoint( whiskers, state );
+
+        continue;
+      }
 
-      continue;
+      state.action.assign( 1, *most_used_whisker_ptr );
+      state.prng_seed = eval.prng_seed();
+      state.keep_seed = false;
+      state.score_to_beat = outcome.score;
+      state.eval_cache.clear();
     }
 
-    WhiskerImprover improver( eval, whiskers, _whisker_options, outcome.score );
+    const Evaluator< WhiskerTree > eval( _options.config_range, state.prng_seed );
+    WhiskerImprover improver( eval, whiskers, _whisker_options, state.score_to_beat, _options.racing );
+    improver.restore_eval_cache( state.eval_cache );
 
-    Whisker whisker_to_improve = *most_used_whisker_ptr;
-
-    double score_to_beat = outcome.score;
+    Whisker & whisker_to_improve = state.action.front();
 
     while ( 1 ) {
       double new_score = improver.improve( whisker_to_improve );
-      assert( new_score >= score_to_beat );
-      if ( new_score == score_to_beat ) {
+      assert( new_score >= state.score_to_beat );
+      if ( new_score == state.score_to_beat ) {
 	cerr << "Ending search." << endl;
 	break;
       } else {
-	cerr << "Score jumps from " << score_to_beat << " to " << new_score << endl;
-	score_to_beat = new_score;
+	cerr << "Score jumps from " << state.score_to_beat << " to " << new_score << endl;
+	state.score_to_beat = new_score;
+	state.eval_cache = improver.eval_cache();
+	checkpoint( whiskers, state );
       }
     }
 
-    whisker_to_improve.demote( generation + 1 );
+    whisker_to_improve.demote( state.generation + 1 );
 
     const auto result __attribute((unused)) = whiskers.replace( whisker_to_improve );
     assert( result );
+
+    state.improved.push_back( whisker_to_improve );
+    state.action.clear();
+    checkpoint( whiskers, state );
   }
 
   /* Split most used whisker */
-  apply_best_split( whiskers, generation );
+  apply_best_split( whiskers, state.generation );
 
-  /* carefully evaluate what we have vs. the previous best */
-  const Evaluator< WhiskerTree > eval2( _options.config_range );
+  /* carefully evaluate what we have vs. the previous best, on networks
+     drawn afresh for this round; with a fixed careful seed they are
+     the last round's, so the previous best's score is remembered */
+  const Evaluator< WhiskerTree > eval2( _options.config_range, careful_seed() );
   const auto new_score = eval2.score( whiskers, false, 10 );
-  const auto old_score = eval2.score( input_whiskertree, false, 10 );
+  const auto old_score = eval2.score( state.input_tree, false, 10 );
 
   if ( old_score.score >= new_score.score ) {
     fprintf( stderr, "Regression, old=%f, new=%f\n", old_score.score, new_score.score );
-    whiskers = input_whiskertree;
+    whiskers = state.input_tree;
     return old_score;
   }
 
@@ -19,8 +19,8 @@ protected:
 
 public:
   WhiskerImprover( const Evaluator<  WhiskerTree > & evaluator, const WhiskerTree & rat, const WhiskerImproverOptions & options,
-                   const double score_to_beat )
-    : ActionImprover< WhiskerTree, Whisker >( evaluator, rat, score_to_beat),
+                   const double score_to_beat, const RacingSchedule & racing )
+    : ActionImprover< WhiskerTree, Whisker >( evaluator, rat, score_to_beat, racing ),
       _options( options ) {};
 };
 
@@ -33,7 +33,7 @@ public:
   RatBreeder( const BreederOptions & s_options, const WhiskerImproverOptions & s_whisker_options ) 
     : Breeder( s_options ), _whisker_options( s_whisker_options ) {};
 
-  Evaluator< WhiskerTree >::Outcome improve( WhiskerTree & whiskers );
+  Evaluator< WhiskerTree >::Outcome resume( WhiskerTree & whiskers, BreederState< WhiskerTree > & state );
 };
 
 #endif
@@ -3,32 +3,64 @@
 
 #include "receiver.hh"
 
-Receiver::Receiver()
-  : _collector()
+/* room for a few ACKs per sender per tick before the slots must grow */
+static const unsigned int initial_slot_capacity = 4;
+
+Receiver::Receiver( const unsigned int num_senders )
+  : _slots(),
+    _slot_capacity( initial_slot_capacity ),
+    _counts(),
+    _readable(),
+    _readable_count( 0 )
 {
+  autosize( num_senders ? num_senders - 1 : 0 );
 }
 
 void Receiver::accept( const Packet & p, const double & tickno ) noexcept
 {
   autosize( p.src );
 
-  _collector[ p.src ].push_back( p );
-  _collector[ p.src ].back().tick_received = tickno;
+  unsigned int & count = _counts[ p.src ];
+  if ( count == _slot_capacity ) {
+    grow_slots();
+  }
+
+  if ( count == 0 ) {
+    _readable[ p.src / 64 ] |= uint64_t( 1 ) << (p.src % 64);
+    _readable_count++;
+  }
+
+  Packet & slot = _slots[ p.src * _slot_capacity + count ];
+  slot = p;
+  slot.tick_received = tickno;
+  count++;
 }
 
 void Receiver::autosize( const unsigned int index )
 {
-  if ( index >= _collector.size() ) {
-    _collector.resize( index + 1 );
+  if ( index >= _counts.size() ) {
+    _counts.resize( index + 1, 0 );
+    _readable.resize( (index + 64) / 64, 0 );
+    _slots.resize( _counts.size() * _slot_capacity, Packet( 0, 0, 0, 0 ) );
   }
 }
 
-double Receiver::next_event_time( const double & tickno ) const
+void Receiver::grow_slots( void )
 {
-  for ( const auto & x : _collector ) {
-    if ( not x.empty() ) {
-      return tickno;
+  const unsigned int new_capacity = 2 * _slot_capacity;
+  std::vector< Packet > slots( _counts.size() * new_capacity, Packet( 0, 0, 0, 0 ) );
+
+  for ( unsigned int src = 0; src < _counts.size(); src++ ) {
+    for ( unsigned int i = 0; i < _counts[ src ]; i++ ) {
+      slots[ src * new_capacity + i ] = _slots[ src * _slot_capacity + i ];
     }
   }
-  return std::numeric_limits<double>::max();
+
+  _slots.swap( slots );
+  _slot_capacity = new_capacity;
+}
+
+double Receiver::next_event_time( const double & tickno ) const
+{
+  return _readable_count ? tickno : std::numeric_limits<double>::max();
 }
@@ -1,26 +1,82 @@
 #ifndef RECEIVER_HH
 #define RECEIVER_HH
 
+#include <algorithm>
+#include <cstdint>
 #include <vector>
 
 #include "packet.hh"
 
+/* Holds each sender's ACKs until its next tick. Every sender has a
+   fixed-capacity slot in one array (all slots double together in the
+   rare tick that one overflows), and a bitmap marks the senders with
+   packets waiting, so nothing is allocated in the steady state. */
 class Receiver
 {
 private:
-  std::vector< std::vector< Packet > > _collector;
+  std::vector< Packet > _slots;
+  unsigned int _slot_capacity;
+  std::vector< unsigned int > _counts;
+  std::vector< uint64_t > _readable; /* bitmap of senders with packets waiting */
+  unsigned int _readable_count;
+
   void autosize( const unsigned int index );
+  void grow_slots( void );
 
 public:
-  Receiver();
+  Receiver( const unsigned int num_senders = 0 );
 
   void accept( const Packet & p, const double & tickno ) noexcept;
-  const std::vector< Packet > & packets_for( const unsigned int src ) { return _collector[ src ]; }
-  void clear( const unsigned int src ) { _collector[ src ].clear(); }
+
+  /* valid until the next accept() */
+  PacketSpan packets_for( const unsigned int src ) const
+  {
+    return PacketSpan( _slots.data() + src * _slot_capacity, _counts[ src ] );
+  }
+
+  void clear( const unsigned int src )
+  {
+    if ( _counts[ src ] ) {
+      _counts[ src ] = 0;
+      _readable[ src / 64 ] &= ~(uint64_t( 1 ) << (src % 64));
+      _readable_count--;
+    }
+  }
+
   bool readable( const unsigned int src ) const noexcept
-  { return (src < _collector.size()) && (!_collector[ src ].empty()); }
+  {
+    return (src < _counts.size()) && ((_readable[ src / 64 ] >> (src % 64)) & 1);
+  }
+
+  /* calls f( src ) for each sender in [begin, end) with packets waiting */
+  template <typename Function>
+  void for_each_readable( const unsigned int begin, unsigned int end, Function && f ) const
+  {
+    if ( _readable_count == 0 or begin >= end ) {
+      return;
+    }
+
+    end = std::min< unsigned int >( end, _counts.size() );
+    for ( unsigned int word = begin / 64; word * 64 < end; word++ ) {
+      uint64_t bits = _readable[ word ];
+      while ( bits ) {
+	const unsigned int src = word * 64 + __builtin_ctzll( bits );
+	bits &= bits - 1;
+	if ( src >= begin and src < end ) {
+	  f( src );
+	}
+      }
+    }
+  }
 
   double next_event_time( const double & tickno ) const;
+
+  /* bytes held on the heap */
+  size_t footprint( void ) const
+  {
+    return _slots.capacity() * sizeof( Packet ) + _counts.capacity() * sizeof( unsigned int )
+      + _readable.capacity() * sizeof( uint64_t );
+  }
 };
 
 #endif
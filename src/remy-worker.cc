@@ -0,0 +1,86 @@
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "evaluator.hh"
+#include "messagesocket.hh"
+#include "threadpool.hh"
+
+using namespace std;
+
+/* answer every Problem on the stream until it is closed */
+static void serve( const int in_fd, const int out_fd )
+{
+  ProblemBuffers::Problem problem;
+  while ( receive_message( in_fd, problem ) ) {
+    AnswerBuffers::Outcome answer;
+    if ( problem.has_whiskers() ) {
+      answer = Evaluator< WhiskerTree >::parse_problem_and_evaluate( problem ).DNA();
+    } else if ( problem.has_fins() ) {
+      answer = Evaluator< FinTree >::parse_problem_and_evaluate( problem ).DNA();
+    } else {
+      fprintf( stderr, "Problem has neither whiskers nor fins.\n" );
+      break;
+    }
+
+    if ( not send_message( out_fd, answer ) ) {
+      break;
+    }
+  }
+}
+
+int main( int argc, char *argv[] )
+{
+  string address;
+
+  for ( int i = 1; i < argc; i++ ) {
+    string arg( argv[ i ] );
+    if ( arg.substr( 0, 7 ) == "socket=" ) {
+      address = arg.substr( 7 );
+
+    } else if ( arg.substr( 0, 8 ) == "threads=" ) {
+      const int num_threads = atoi( arg.substr( 8 ).c_str() );
+      if ( num_threads <= 0 ) {
+        fprintf( stderr, "Invalid number of threads: %s\n", arg.substr( 8 ).c_str() );
+        exit( 1 );
+      }
+      set_global_thread_pool_size( num_threads );
+
+    } else {
+      fprintf( stderr, "Usage: %s [socket=PATH|HOST:PORT] [threads=N]\n", argv[ 0 ] );
+      exit( 1 );
+    }
+  }
+
+  /* a dispatcher that goes away shows up as a failed write */
+  signal( SIGPIPE, SIG_IGN );
+
+  if ( address.empty() ) {
+    /* one dispatcher, over a pipe */
+    serve( STDIN_FILENO, STDOUT_FILENO );
+    return 0;
+  }
+
+  const int listener = listen_socket( address );
+  fprintf( stderr, "Listening on %s with %u threads.\n", address.c_str(), global_thread_pool().size() );
+
+  while ( 1 ) {
+    const int fd = accept( listener, nullptr, nullptr );
+    if ( fd < 0 ) {
+      perror( "accept" );
+      continue;
+    }
+
+    /* each connection gets its own thread, and they share the pool */
+    thread( [fd] () {
+	serve( fd, fd );
+	close( fd );
+      } ).detach();
+  }
+
+  return 0;
+}
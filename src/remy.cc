@@ -1,6 +1,7 @@
 #include <cstdio>
 #include <vector>
 #include <string>
+#include <sstream>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -9,6 +10,10 @@
 #include "ratbreeder.hh"
 #include "dna.pb.h"
 #include "configrange.hh"
+#include "threadpool.hh"
+#include "checkpoint.hh"
+#include "evalcache.hh"
+#include "dispatcher.hh"
 using namespace std;
 
 void print_range( const Range & range, const string & name )
@@ -25,6 +30,11 @@ int main( int argc, char *argv[] )
   WhiskerImproverOptions whisker_options;
   RemyBuffers::ConfigRange input_config;
   string config_filename;
+  string checkpoint_filename;
+  string resume_filename;
+  string racing_stages;
+  bool racing_set = false;
+  double racing_confidence = options.racing.confidence;
 
   for ( int i = 1; i < argc; i++ ) {
     string arg( argv[ i ] );
@@ -51,6 +61,70 @@ int main( int argc, char *argv[] )
     } else if ( arg.substr( 0, 3 ) == "of=" ) {
       output_filename = string( arg.substr( 3 ) );
 
+    } else if ( arg.substr( 0, 11 ) == "checkpoint=" ) {
+      checkpoint_filename = string( arg.substr( 11 ) );
+
+    } else if ( arg.substr( 0, 11 ) == "eval_cache=" ) {
+      set_global_eval_cache_file( arg.substr( 11 ) );
+
+    } else if ( arg.substr( 0, 8 ) == "workers=" ) {
+      vector< string > workers;
+      istringstream list( arg.substr( 8 ) );
+      string worker;
+      while ( getline( list, worker, ',' ) ) {
+        workers.push_back( worker );
+      }
+      set_global_dispatcher_workers( workers );
+
+    } else if ( arg.substr( 0, 15 ) == "worker_timeout=" ) {
+      const int timeout = atoi( arg.substr( 15 ).c_str() );
+      if ( timeout <= 0 or timeout > 1000000 ) {
+        fprintf( stderr, "Invalid worker timeout: %s\n", arg.substr( 15 ).c_str() );
+        exit( 1 );
+      }
+      set_global_dispatcher_timeout( timeout );
+
+    } else if ( arg.substr( 0, 11 ) == "parking_mb=" ) {
+      const unsigned int megabytes = atoi( arg.substr( 11 ).c_str() );
+      if ( arg.size() == 11 or arg.substr( 11 ).find_first_not_of( "0123456789" ) != string::npos ) {
+        fprintf( stderr, "Invalid parking budget: %s\n", arg.substr( 11 ).c_str() );
+        exit( 1 );
+      }
+      set_global_parking_budget( size_t( megabytes ) << 20 );
+
+    } else if ( arg.substr( 0, 7 ) == "resume=" ) {
+      resume_filename = string( arg.substr( 7 ) );
+
+    } else if ( arg.substr( 0, 8 ) == "threads=" ) {
+      const int num_threads = atoi( arg.substr( 8 ).c_str() );
+      if ( num_threads <= 0 ) {
+        fprintf( stderr, "Invalid number of threads: %s\n", arg.substr( 8 ).c_str() );
+        exit( 1 );
+      }
+      set_global_thread_pool_size( num_threads );
+
+    } else if ( arg.substr( 0, 7 ) == "racing=" ) {
+      racing_stages = arg.substr( 7 );
+      racing_set = true;
+
+    } else if ( arg.substr( 0, 13 ) == "careful_seed=" ) {
+      const string mode( arg.substr( 13 ) );
+      if ( mode == "fixed" ) {
+        options.fixed_careful_seed = true;
+      } else if ( mode == "fresh" ) {
+        options.fixed_careful_seed = false;
+      } else {
+        fprintf( stderr, "Invalid careful seed: %s (expected fixed or fresh)\n", mode.c_str() );
+        exit( 1 );
+      }
+
+    } else if ( arg.substr( 0, 18 ) == "racing_confidence=" ) {
+      racing_confidence = atof( arg.substr( 18 ).c_str() );
+      if ( racing_confidence < 0 ) {
+        fprintf( stderr, "Invalid racing confidence: %s\n", arg.substr( 18 ).c_str() );
+        exit( 1 );
+      }
+
     } else if ( arg.substr( 0, 4 ) == "opt=" ) {
       whisker_options.optimize_window_increment = false;
       whisker_options.optimize_window_multiple = false;
@@ -86,7 +160,37 @@ int main( int argc, char *argv[] )
     }
   }
 
-  if ( config_filename.empty() ) {
+  options.racing = racing_set ? RacingSchedule::parse( racing_stages ) : RacingSchedule();
+  options.racing.confidence = racing_confidence;
+
+  unsigned int run = 0;
+  RemyBuffers::ConfigVector training_configs;
+  BreederState< WhiskerTree > resume_state;
+  bool resuming = false;
+  vector< unsigned int > careful_seed;
+
+  if ( !resume_filename.empty() ) {
+    /* carry on from the checkpoint, with the settings it was made with */
+    const auto checkpoint = read_checkpoint( resume_filename );
+    whiskers = WhiskerTree( checkpoint.whiskers() );
+    input_config = checkpoint.whiskers().config();
+    options.racing = RacingSchedule( checkpoint.whiskers().racing() );
+    training_configs = checkpoint.whiskers().configvector();
+    whisker_options.optimize_window_increment = checkpoint.optimize_window_increment();
+    whisker_options.optimize_window_multiple = checkpoint.optimize_window_multiple();
+    whisker_options.optimize_intersend = checkpoint.optimize_intersend();
+    run = checkpoint.run();
+    restore_global_PRNG_state( checkpoint.prng_state() );
+    options.fixed_careful_seed = checkpoint.fixed_careful_seed() or checkpoint.has_careful_seed();
+    if ( checkpoint.has_careful_seed() ) {
+      careful_seed.push_back( checkpoint.careful_seed() );
+    }
+
+    if ( checkpoint.has_breeder() ) {
+      resume_state = BreederState< WhiskerTree >( checkpoint.breeder() );
+      resuming = true;
+    }
+  } else if ( config_filename.empty() ) {
     fprintf( stderr, "An input configuration protobuf must be provided via the cf= option. \n");
     fprintf( stderr, "You can generate one using './configuration'. \n");
     exit ( 1 );
@@ -94,13 +198,59 @@ int main( int argc, char *argv[] )
 
   options.config_range = ConfigRange( input_config );
 
+  bool written = training_configs.config_size() > 0;
+
+  auto remycc_DNA = [&] ( const WhiskerTree & tree ) {
+    auto remycc = tree.DNA();
+    remycc.mutable_config()->CopyFrom( options.config_range.DNA() );
+    remycc.mutable_optimizer()->CopyFrom( Whisker::get_optimizer().DNA() );
+    remycc.mutable_configvector()->CopyFrom( training_configs );
+    remycc.mutable_racing()->CopyFrom( options.racing.DNA() );
+    return remycc;
+  };
+
   RatBreeder breeder( options, whisker_options );
+  breeder.restore_careful_seed( careful_seed );
 
-  unsigned int run = 0;
+  bool checkpointed = false;
+  auto save_checkpoint = [&] ( const WhiskerTree & tree, const BreederState< WhiskerTree > * state ) {
+    if ( checkpoint_filename.empty() ) {
+      return;
+    }
+
+    CheckpointBuffers::Checkpoint checkpoint;
+    checkpoint.mutable_whiskers()->CopyFrom( remycc_DNA( tree ) );
+    checkpoint.set_run( run );
+    checkpoint.set_prng_state( global_PRNG_state() );
+    if ( state ) {
+      checkpoint.mutable_breeder()->CopyFrom( state->DNA() );
+    }
+    checkpoint.set_fixed_careful_seed( options.fixed_careful_seed );
+    if ( not breeder.saved_careful_seed().empty() ) {
+      checkpoint.set_careful_seed( breeder.saved_careful_seed().front() );
+    }
+    checkpoint.set_optimize_window_increment( whisker_options.optimize_window_increment );
+    checkpoint.set_optimize_window_multiple( whisker_options.optimize_window_multiple );
+    checkpoint.set_optimize_intersend( whisker_options.optimize_intersend );
+
+    write_atomically( checkpoint, checkpoint_filename );
+    checkpointed = true;
+  };
+
+  breeder.set_checkpoint( [&] ( const WhiskerTree & tree, const BreederState< WhiskerTree > & state ) {
+      save_checkpoint( tree, &state ); } );
 
   printf( "#######################\n" );
   printf( "Evaluator simulations will run for %d ticks\n",
     options.config_range.simulation_ticks );
+  printf( "Evaluating on %u threads (use threads=N to change)\n",
+    global_thread_pool().size() );
+  printf( "Racing candidates with %s (use racing=TICKS/CONFIGS/KEEP,... to change)\n",
+    options.racing.str().c_str() );
+  printf( "Careful comparisons use %s (use careful_seed=%s to change; a fixed seed\n"
+          "  reuses scores but judges every round on the same networks)\n",
+          options.fixed_careful_seed ? "one seed for the whole run" : "a fresh seed each round",
+          options.fixed_careful_seed ? "fresh" : "fixed" );
   printf( "Optimizing window increment: %d, window multiple: %d, intersend: %d\n",
           whisker_options.optimize_window_increment, whisker_options.optimize_window_multiple,
           whisker_options.optimize_intersend);
@@ -125,11 +275,39 @@ int main( int argc, char *argv[] )
     printf( "Not saving output. Use the of=FILENAME argument to save the results.\n" );
   }
 
-  RemyBuffers::ConfigVector training_configs;
-  bool written = false;
+  if ( global_dispatcher().enabled() ) {
+    printf( "Dispatching simulations to %u remy-worker connections (use worker_timeout=SECONDS to change the timeout of %u s).\n",
+	    global_dispatcher().size(), global_dispatcher().timeout() );
+  }
+
+  if ( global_eval_cache().enabled() ) {
+    printf( "Reusing simulation results from an evaluation cache of %lu entries.\n",
+	    (unsigned long) global_eval_cache().size() );
+  }
+
+  if ( !checkpoint_filename.empty() ) {
+    printf( "Checkpointing to \"%s\" after every step.\n", checkpoint_filename.c_str() );
+  }
+
+  if ( !resume_filename.empty() ) {
+    printf( "Resuming run %u from \"%s\".\n", run, resume_filename.c_str() );
+  }
 
   while ( 1 ) {
-    auto outcome = breeder.improve( whiskers );
+    Evaluator< WhiskerTree >::Outcome outcome;
+    try {
+      outcome = resuming ? breeder.resume( whiskers, resume_state ) : breeder.improve( whiskers );
+    } catch ( const DispatchFailure & e ) {
+      /* the checkpoint of the last step stands: a new one would record
+         the PRNG draws made since, and a resumed run would differ */
+      fprintf( stderr, "Giving up: %s.\n", e.what() );
+      if ( checkpointed ) {
+        fprintf( stderr, "Use resume=%s to carry on from the last step once the workers can be reached.\n",
+                 checkpoint_filename.c_str() );
+      }
+      exit( 1 );
+    }
+    resuming = false;
     printf( "run = %u, score = %f\n", run, outcome.score );
 
     printf( "whiskers: %s\n", whiskers.str().c_str() );
@@ -150,6 +328,11 @@ int main( int argc, char *argv[] )
       }
     }
 
+    for ( unsigned int i = 0; i < outcome.profiles.size(); i++ ) {
+      printf( "===\nprofile of config: %s\n%s", outcome.throughputs_delays.at( i ).first.str().c_str(),
+	      outcome.profiles.at( i ).str().c_str() );
+    }
+
     if ( !output_filename.empty() ) {
       char of[ 128 ];
       snprintf( of, 128, "%s.%d", output_filename.c_str(), run );
@@ -160,10 +343,7 @@ int main( int argc, char *argv[] )
 	exit( 1 );
       }
 
-      auto remycc = whiskers.DNA();
-      remycc.mutable_config()->CopyFrom( options.config_range.DNA() );
-      remycc.mutable_optimizer()->CopyFrom( Whisker::get_optimizer().DNA() );
-      remycc.mutable_configvector()->CopyFrom( training_configs );
+      auto remycc = remycc_DNA( whiskers );
       if ( not remycc.SerializeToFileDescriptor( fd ) ) {
 	fprintf( stderr, "Could not serialize RemyCC.\n" );
 	exit( 1 );
@@ -179,6 +359,8 @@ int main( int argc, char *argv[] )
 
     fflush( NULL );
     run++;
+
+    save_checkpoint( whiskers, nullptr );
   }
 
   return 0;
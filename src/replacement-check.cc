@@ -0,0 +1,289 @@
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "evaluator.hh"
+
+using namespace std;
+
+/* Scores replacements for one of a RemyCC's actions the way the
+   ActionImprover does, with Evaluator::score_replacements, and checks
+   that every score is identical, bit for bit, to that of the replaced
+   tree evaluated on its own with Evaluator::score. */
+
+typedef Evaluator< WhiskerTree > WhiskerEvaluator;
+
+static WhiskerTree read_tree( const string & filename )
+{
+  int fd = open( filename.c_str(), O_RDONLY );
+  if ( fd < 0 ) {
+    perror( "open" );
+    exit( 1 );
+  }
+
+  RemyBuffers::WhiskerTree tree;
+  if ( !tree.ParseFromFileDescriptor( fd ) ) {
+    fprintf( stderr, "Could not parse %s.\n", filename.c_str() );
+    exit( 1 );
+  }
+
+  if ( close( fd ) < 0 ) {
+    perror( "close" );
+    exit( 1 );
+  }
+
+  return WhiskerTree( tree );
+}
+
+/* a small fixed set of networks */
+static ConfigRange check_range( const unsigned int ticks )
+{
+  ConfigRange ret;
+  ret.link_ppt = Range( 0.5, 2, 1.5 );
+  ret.rtt = Range( 100, 100, 0 );
+  ret.mean_on_duration = Range( 1000, 1000, 0 );
+  ret.mean_off_duration = Range( 1000, 1000, 0 );
+  ret.num_senders = Range( 2, 8, 6 );
+  ret.buffer_size = Range( numeric_limits< unsigned int >::max(), numeric_limits< unsigned int >::max(), 0 );
+  ret.simulation_ticks = ticks;
+  return ret;
+}
+
+/* the leaves an evaluation used, most used first */
+static vector< Whisker > used_leaves( WhiskerTree tree )
+{
+  vector< Whisker > ret;
+  tree.reset_generation();
+  while ( const Whisker * leaf = tree.most_used( 0 ) ) {
+    ret.push_back( *leaf );
+    Whisker done( *leaf );
+    done.demote( 1 );
+    tree.replace( done );
+  }
+  return ret;
+}
+
+/* a few of the candidates the improver would try for leaf, spread
+   over all of them */
+static vector< Whisker > replacements_for( const Whisker & leaf )
+{
+  const vector< Whisker > candidates( leaf.next_generation( true, true, true ) );
+  vector< Whisker > ret;
+  for ( unsigned int i = 0; i < 4; i++ ) {
+    ret.push_back( candidates.at( i * candidates.size() / 4 ) );
+  }
+  return ret;
+}
+
+/* compares per-config scores of replacements with full evaluations of
+   the replaced trees; returns the number that differ */
+static unsigned int compare( const WhiskerEvaluator & eval,
+			     const WhiskerTree & tree,
+			     const vector< Whisker > & replacements,
+			     const vector< vector< double > > & scores )
+{
+  unsigned int mismatches = 0;
+  for ( unsigned int j = 0; j < replacements.size(); j++ ) {
+    WhiskerTree replaced( tree );
+    if ( not replaced.replace( replacements.at( j ) ) ) {
+      fprintf( stderr, "Replacement %s is not in the tree.\n", replacements.at( j ).str().c_str() );
+      exit( 1 );
+    }
+
+    double score = 0;
+    for ( const auto & x : scores.at( j ) ) {
+      score += x;
+    }
+
+    const double reference = eval.score( replaced ).score;
+    const bool same = score == reference;
+    mismatches += not same;
+    printf( "replacement %u: score=%.17g, on its own %.17g: %s\n", j, score, reference,
+	    same ? "identical" : "DIFFERENT" );
+  }
+  return mismatches;
+}
+
+/* races the replacements through shortened runs, as the improver does,
+   so that each evaluation carries on the runs the one before it kept */
+static unsigned int check_resume( const WhiskerEvaluator & eval,
+				  const WhiskerTree & tree,
+				  const bool parking )
+{
+  WhiskerTree used( tree );
+  const vector< Whisker > replacements( replacements_for( used_leaves( eval.score( used ).used_actions ).front() ) );
+
+  const uint64_t resumed_before = WhiskerEvaluator::runs_resumed();
+  eval.score_replacements( tree, replacements, 0.1, eval.num_configs() );
+  eval.score_replacements( tree, replacements, 0.3, eval.num_configs() );
+  const auto scores = eval.score_replacements( tree, replacements, 1, eval.num_configs() );
+  const uint64_t resumed = WhiskerEvaluator::runs_resumed() - resumed_before;
+
+  printf( "%lu runs carried on\n", resumed );
+  if ( parking ? resumed == 0 : resumed > 0 ) {
+    fprintf( stderr, "Expected %s runs to be carried on.\n", parking ? "some" : "no" );
+    exit( 1 );
+  }
+
+  return compare( eval, tree, replacements, scores );
+}
+
+/* replaces a leaf that no config uses in the first half of its run,
+   so that the replacements share the simulation up to there and all
+   but the first are forked from a snapshot taken late in the run */
+static unsigned int check_fork( const WhiskerEvaluator & eval,
+				const WhiskerTree & tree )
+{
+  WhiskerTree half_run( tree ), full_run( tree );
+  const vector< Whisker > early( used_leaves( eval.score( half_run, false, 0.5 ).used_actions ) );
+
+  for ( const auto & leaf : used_leaves( eval.score( full_run ).used_actions ) ) {
+    bool used_early = false;
+    for ( const auto & x : early ) {
+      used_early |= x.domain() == leaf.domain();
+    }
+    if ( used_early ) {
+      continue;
+    }
+
+    printf( "Replacing an action first used in the second half of the run: %s\n", leaf.str().c_str() );
+    const vector< Whisker > replacements( replacements_for( leaf ) );
+    return compare( eval, tree, replacements,
+		    eval.score_replacements( tree, replacements, 1, eval.num_configs() ) );
+  }
+
+  fprintf( stderr, "No action is first used in the second half of the run.\n" );
+  exit( 1 );
+}
+
+/* scores replacements for leaf after a full evaluation of the tree,
+   and checks that exactly expected_reused configs kept its score */
+static unsigned int check_reused( const WhiskerEvaluator & eval,
+				  const WhiskerTree & tree,
+				  const Whisker & leaf,
+				  const unsigned int expected_reused )
+{
+  const vector< Whisker > replacements( replacements_for( leaf ) );
+
+  const uint64_t reused_before = WhiskerEvaluator::configs_reused();
+  const auto scores = eval.score_replacements( tree, replacements, 1, eval.num_configs() );
+  const uint64_t reused = WhiskerEvaluator::configs_reused() - reused_before;
+
+  const bool expected = reused == expected_reused;
+  printf( "%lu configs kept the tree's score, expected %u: %s\n", reused, expected_reused,
+	  expected ? "as expected" : "WRONG" );
+
+  return compare( eval, tree, replacements, scores ) + not expected;
+}
+
+/* replaces a leaf that only some configs use, whose other configs
+   should keep the tree's own score, and one that every config uses */
+static unsigned int check_reuse( const WhiskerEvaluator & eval,
+				 const WhiskerTree & tree )
+{
+  WhiskerTree full_run( tree );
+  const vector< Whisker > leaves( used_leaves( eval.score( full_run ).used_actions ) );
+
+  /* which leaves each config uses, from runs of each config on its
+     own with the seed it gets in the full evaluation */
+  const ProblemBuffers::Problem problem( eval.DNA( tree ) );
+  const vector< unsigned int > seeds( WhiskerEvaluator::problem_seeds( problem ) );
+  vector< vector< Whisker > > config_leaves;
+  for ( int i = 0; i < problem.configs_size(); i++ ) {
+    ProblemBuffers::Problem one;
+    one.mutable_settings()->set_tick_count( problem.settings().tick_count() );
+    one.mutable_settings()->add_config_seeds( seeds.at( i ) );
+    one.add_configs()->CopyFrom( problem.configs( i ) );
+    one.mutable_whiskers()->CopyFrom( problem.whiskers() );
+    config_leaves.push_back( used_leaves( WhiskerEvaluator::parse_problem_and_evaluate( one ).used_actions ) );
+  }
+
+  unsigned int mismatches = 0;
+  bool some = false, every = false;
+  for ( const auto & leaf : leaves ) {
+    unsigned int users = 0;
+    for ( const auto & used : config_leaves ) {
+      for ( const auto & x : used ) {
+	users += x.domain() == leaf.domain();
+      }
+    }
+
+    if ( users == config_leaves.size() and not every ) {
+      printf( "Replacing an action every config uses: %s\n", leaf.str().c_str() );
+      mismatches += check_reused( eval, tree, leaf, 0 );
+      every = true;
+    } else if ( users < config_leaves.size() and not some ) {
+      printf( "Replacing an action %u of %lu configs use: %s\n", users, config_leaves.size(), leaf.str().c_str() );
+      mismatches += check_reused( eval, tree, leaf, config_leaves.size() - users );
+      some = true;
+    }
+  }
+
+  if ( not some or not every ) {
+    fprintf( stderr, "No action is used by %s config.\n", some ? "every" : "only some" );
+    exit( 1 );
+  }
+
+  return mismatches;
+}
+
+int main( int argc, char *argv[] )
+{
+  string tree_filename;
+  string check;
+  unsigned int ticks = 30000;
+  unsigned int seed = 1;
+  bool parking = true;
+
+  for ( int i = 1; i < argc; i++ ) {
+    string arg( argv[ i ] );
+    if ( arg.substr( 0, 5 ) == "tree=" ) {
+      tree_filename = arg.substr( 5 );
+    } else if ( arg.substr( 0, 6 ) == "check=" ) {
+      check = arg.substr( 6 );
+    } else if ( arg.substr( 0, 6 ) == "ticks=" ) {
+      ticks = atoi( arg.substr( 6 ).c_str() );
+    } else if ( arg.substr( 0, 5 ) == "seed=" ) {
+      seed = atoi( arg.substr( 5 ).c_str() );
+    } else if ( arg.substr( 0, 11 ) == "parking_mb=" ) {
+      const unsigned int megabytes = atoi( arg.substr( 11 ).c_str() );
+      set_global_parking_budget( size_t( megabytes ) << 20 );
+      parking = megabytes > 0;
+    } else {
+      fprintf( stderr, "Usage: %s tree=REMYCC check=resume|fork|reuse [ticks=TICKS] [seed=SEED] [parking_mb=MB]\n", argv[ 0 ] );
+      exit( 1 );
+    }
+  }
+
+  if ( tree_filename.empty() or ticks == 0 ) {
+    fprintf( stderr, "Give tree=REMYCC and a nonzero number of ticks.\n" );
+    exit( 1 );
+  }
+
+  const WhiskerTree tree( read_tree( tree_filename ) );
+  const WhiskerEvaluator eval( check_range( ticks ), seed );
+
+  unsigned int mismatches = 0;
+  if ( check == "resume" ) {
+    mismatches = check_resume( eval, tree, parking );
+  } else if ( check == "fork" ) {
+    mismatches = check_fork( eval, tree );
+  } else if ( check == "reuse" ) {
+    mismatches = check_reuse( eval, tree );
+  } else {
+    fprintf( stderr, "Unknown check: %s\n", check.c_str() );
+    exit( 1 );
+  }
+
+  if ( mismatches ) {
+    printf( "%u scores differ.\n", mismatches );
+    return 1;
+  }
+
+  printf( "All scores are identical.\n" );
+  return 0;
+}
@@ -0,0 +1,242 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "evaluator.hh"
+#include "messagesocket.hh"
+#include "threadpool.hh"
+
+using namespace std;
+
+/* Runs one problem several times -- with 1 to N threads, and with the
+   work shuffled among the threads -- and checks that every run gives
+   the same outcome, bit for bit. Each run is in its own child process,
+   because the size of the global thread pool is fixed once it exists. */
+
+static AnswerBuffers::Outcome evaluate( const ProblemBuffers::Problem & problem )
+{
+  if ( problem.has_whiskers() ) {
+    return Evaluator< WhiskerTree >::parse_problem_and_evaluate( problem ).DNA();
+  } else if ( problem.has_fins() ) {
+    return Evaluator< FinTree >::parse_problem_and_evaluate( problem ).DNA();
+  }
+
+  fprintf( stderr, "Problem has neither whiskers nor fins.\n" );
+  exit( 1 );
+}
+
+static vector< unsigned int > problem_seeds( const ProblemBuffers::Problem & problem )
+{
+  return problem.has_whiskers() ? Evaluator< WhiskerTree >::problem_seeds( problem )
+    : Evaluator< FinTree >::problem_seeds( problem );
+}
+
+static double seconds_since( const chrono::steady_clock::time_point & start )
+{
+  return chrono::duration< double >( chrono::steady_clock::now() - start ).count();
+}
+
+/* evaluate in a child process with the given thread pool; returns the wall time */
+static double evaluate_in_child( const ProblemBuffers::Problem & problem,
+				 const unsigned int num_threads,
+				 const unsigned int shuffle_seed,
+				 AnswerBuffers::Outcome & answer )
+{
+  int fds[ 2 ];
+  if ( pipe( fds ) < 0 ) {
+    perror( "pipe" );
+    exit( 1 );
+  }
+
+  const auto start = chrono::steady_clock::now();
+
+  const pid_t pid = fork();
+  if ( pid < 0 ) {
+    perror( "fork" );
+    exit( 1 );
+  }
+
+  if ( pid == 0 ) {
+    close( fds[ 0 ] );
+    set_global_thread_pool_size( num_threads );
+    set_global_thread_pool_shuffle_seed( shuffle_seed );
+    _exit( send_message( fds[ 1 ], evaluate( problem ) ) ? 0 : 1 );
+  }
+
+  close( fds[ 1 ] );
+  const bool received = receive_message( fds[ 0 ], answer );
+  close( fds[ 0 ] );
+
+  int status;
+  if ( waitpid( pid, &status, 0 ) < 0 ) {
+    perror( "waitpid" );
+    exit( 1 );
+  }
+
+  if ( not received or not WIFEXITED( status ) or WEXITSTATUS( status ) != 0 ) {
+    fprintf( stderr, "Evaluation with %u threads failed.\n", num_threads );
+    exit( 1 );
+  }
+
+  return seconds_since( start );
+}
+
+/* a problem for a saved RemyCC on a small fixed set of networks */
+static ProblemBuffers::Problem problem_for_tree( const string & filename,
+						 const unsigned int ticks,
+						 const unsigned int seed )
+{
+  int fd = open( filename.c_str(), O_RDONLY );
+  if ( fd < 0 ) {
+    perror( "open" );
+    exit( 1 );
+  }
+
+  RemyBuffers::WhiskerTree tree;
+  if ( !tree.ParseFromFileDescriptor( fd ) ) {
+    fprintf( stderr, "Could not parse %s.\n", filename.c_str() );
+    exit( 1 );
+  }
+
+  if ( close( fd ) < 0 ) {
+    perror( "close" );
+    exit( 1 );
+  }
+
+  ProblemBuffers::Problem ret;
+  ret.mutable_settings()->set_prng_seed( seed );
+  ret.mutable_settings()->set_tick_count( ticks );
+  for ( const double link_ppt : { 0.3, 1.0, 3.0 } ) {
+    for ( const double num_senders : { 2, 8 } ) {
+      ret.add_configs()->CopyFrom( NetConfig().set_link_ppt( link_ppt ).set_delay( 100 )
+				   .set_num_senders( num_senders ).DNA() );
+    }
+  }
+  ret.mutable_whiskers()->CopyFrom( tree );
+
+  return ret;
+}
+
+int main( int argc, char *argv[] )
+{
+  ProblemBuffers::Problem problem;
+  bool have_problem = false;
+  string tree_filename;
+  unsigned int max_threads = max( 2u, thread::hardware_concurrency() );
+  unsigned int num_shuffles = 3;
+  unsigned int ticks = 100000;
+  unsigned int seed = 1;
+
+  for ( int i = 1; i < argc; i++ ) {
+    string arg( argv[ i ] );
+    if ( arg.substr( 0, 3 ) == "if=" ) {
+      string filename( arg.substr( 3 ) );
+      int fd = open( filename.c_str(), O_RDONLY );
+      if ( fd < 0 ) {
+	perror( "open" );
+	exit( 1 );
+      }
+
+      if ( !problem.ParseFromFileDescriptor( fd ) ) {
+	fprintf( stderr, "Could not parse %s.\n", filename.c_str() );
+	exit( 1 );
+      }
+
+      if ( close( fd ) < 0 ) {
+	perror( "close" );
+	exit( 1 );
+      }
+
+      have_problem = true;
+    } else if ( arg.substr( 0, 5 ) == "tree=" ) {
+      tree_filename = arg.substr( 5 );
+    } else if ( arg.substr( 0, 8 ) == "threads=" ) {
+      max_threads = atoi( arg.substr( 8 ).c_str() );
+    } else if ( arg.substr( 0, 9 ) == "shuffles=" ) {
+      num_shuffles = atoi( arg.substr( 9 ).c_str() );
+    } else if ( arg.substr( 0, 6 ) == "ticks=" ) {
+      ticks = atoi( arg.substr( 6 ).c_str() );
+    } else if ( arg.substr( 0, 5 ) == "seed=" ) {
+      seed = atoi( arg.substr( 5 ).c_str() );
+    } else {
+      fprintf( stderr, "Usage: %s if=PROBLEM | tree=REMYCC [ticks=TICKS] [seed=SEED] [threads=N] [shuffles=K]\n", argv[ 0 ] );
+      exit( 1 );
+    }
+  }
+
+  if ( have_problem == not tree_filename.empty() ) {
+    fprintf( stderr, "Give one of if=PROBLEM or tree=REMYCC.\n" );
+    exit( 1 );
+  }
+
+  if ( max_threads == 0 ) {
+    fprintf( stderr, "Invalid number of threads.\n" );
+    exit( 1 );
+  }
+
+  if ( not have_problem ) {
+    problem = problem_for_tree( tree_filename, ticks, seed );
+  }
+
+  printf( "Problem with %d configs of %u ticks.\n", problem.configs_size(), problem.settings().tick_count() );
+
+  unsigned int mismatches = 0;
+  auto check = [&] ( const AnswerBuffers::Outcome & reference, const AnswerBuffers::Outcome & answer ) {
+    const bool same = answer.SerializeAsString() == reference.SerializeAsString();
+    mismatches += not same;
+    return same ? "identical" : "DIFFERENT";
+  };
+
+  /* the same problem with every number of threads, then shuffled */
+  AnswerBuffers::Outcome reference;
+  double seconds = evaluate_in_child( problem, 1, 0, reference );
+  printf( "threads=1: score=%.17g (%.3f s)\n", reference.score(), seconds );
+
+  for ( unsigned int num_threads = 2; num_threads <= max_threads; num_threads++ ) {
+    AnswerBuffers::Outcome answer;
+    seconds = evaluate_in_child( problem, num_threads, 0, answer );
+    printf( "threads=%u: score=%.17g (%.3f s) %s\n", num_threads, answer.score(), seconds,
+	    check( reference, answer ) );
+  }
+
+  for ( unsigned int shuffle = 1; shuffle <= num_shuffles; shuffle++ ) {
+    AnswerBuffers::Outcome answer;
+    seconds = evaluate_in_child( problem, max_threads, shuffle, answer );
+    printf( "threads=%u, shuffle=%u: score=%.17g (%.3f s) %s\n", max_threads, shuffle,
+	    answer.score(), seconds, check( reference, answer ) );
+  }
+
+  /* each config on its own, which also times them one by one */
+  const vector< unsigned int > seeds = problem_seeds( problem );
+  for ( int i = 0; i < problem.configs_size(); i++ ) {
+    ProblemBuffers::Problem single( problem );
+    single.clear_configs();
+    single.add_configs()->CopyFrom( problem.configs( i ) );
+    single.mutable_settings()->clear_config_seeds();
+    single.mutable_settings()->add_config_seeds( seeds.at( i ) );
+
+    AnswerBuffers::Outcome answer;
+    seconds = evaluate_in_child( single, 1, 0, answer );
+
+    AnswerBuffers::Outcome expected;
+    expected.add_throughputs_delays()->CopyFrom( reference.throughputs_delays( i ) );
+    expected.set_score( answer.score() ); /* only the total is in the reference */
+
+    printf( "config %d (%.3f s) %s: %s", i, seconds, check( expected, answer ),
+	    NetConfig( problem.configs( i ) ).str().c_str() );
+  }
+
+  if ( mismatches ) {
+    printf( "%u runs differed from the first.\n", mismatches );
+    return 1;
+  }
+
+  printf( "All runs gave identical outcomes.\n" );
+  return 0;
+}
@@ -0,0 +1,164 @@
+#ifndef RINGBUFFER_HH
+#define RINGBUFFER_HH
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+/* FIFO of packets in one contiguous, power-of-two sized array that
+   doubles when full, for the queues at each hop of the network. */
+template <typename T>
+class RingBuffer
+{
+private:
+  std::allocator< T > _allocator;
+  T * _storage;
+  size_t _mask; /* capacity - 1 */
+  size_t _head;
+  size_t _size;
+
+  T & slot( const size_t i ) const { return _storage[ (_head + i) & _mask ]; }
+
+  void reallocate( const size_t capacity )
+  {
+    T * storage = _allocator.allocate( capacity );
+    for ( size_t i = 0; i < _size; i++ ) {
+      new ( storage + i ) T( std::move( slot( i ) ) );
+      slot( i ).~T();
+    }
+
+    if ( _storage ) {
+      _allocator.deallocate( _storage, _mask + 1 );
+    }
+
+    _storage = storage;
+    _mask = capacity - 1;
+    _head = 0;
+  }
+
+  void clear( void )
+  {
+    while ( not empty() ) {
+      pop_front();
+    }
+  }
+
+public:
+  class const_iterator
+  {
+  private:
+    const RingBuffer * _ring;
+    size_t _index;
+
+  public:
+    const_iterator( const RingBuffer * ring, const size_t index ) : _ring( ring ), _index( index ) {}
+
+    const T & operator*( void ) const { return _ring->slot( _index ); }
+    const_iterator & operator++( void ) { _index++; return *this; }
+    bool operator!=( const const_iterator & other ) const { return _index != other._index; }
+  };
+
+  class iterator
+  {
+  private:
+    RingBuffer * _ring;
+    size_t _index;
+
+  public:
+    iterator( RingBuffer * ring, const size_t index ) : _ring( ring ), _index( index ) {}
+
+    T & operator*( void ) const { return _ring->slot( _index ); }
+    iterator & operator++( void ) { _index++; return *this; }
+    bool operator!=( const iterator & other ) const { return _index != other._index; }
+  };
+
+  RingBuffer() : _allocator(), _storage( nullptr ), _mask( 0 ), _head( 0 ), _size( 0 ) {}
+
+  RingBuffer( const RingBuffer & other )
+    : _allocator(), _storage( nullptr ), _mask( 0 ), _head( 0 ), _size( 0 )
+  {
+    *this = other;
+  }
+
+  RingBuffer & operator=( const RingBuffer & other )
+  {
+    if ( this != &other ) {
+      clear();
+      reserve( other.size() );
+      for ( const auto & x : other ) {
+	push_back( x );
+      }
+    }
+    return *this;
+  }
+
+  ~RingBuffer()
+  {
+    clear();
+    if ( _storage ) {
+      _allocator.deallocate( _storage, _mask + 1 );
+    }
+  }
+
+  /* bytes of element storage held */
+  size_t footprint( void ) const { return _storage ? (_mask + 1) * sizeof( T ) : 0; }
+
+  /* make room for at least n elements without further allocation */
+  void reserve( const size_t n )
+  {
+    if ( _storage and n <= _mask + 1 ) {
+      return;
+    }
+
+    size_t capacity = 1;
+    while ( capacity < n ) {
+      capacity <<= 1;
+    }
+    reallocate( capacity );
+  }
+
+  template <typename... Args>
+  void emplace_back( Args &&... args )
+  {
+    if ( not _storage or _size > _mask ) {
+      reallocate( _storage ? 2 * (_mask + 1) : 16 );
+    }
+    new ( &slot( _size ) ) T( std::forward< Args >( args )... );
+    _size++;
+  }
+
+  void push_back( const T & x ) { emplace_back( x ); }
+
+  void pop_front( void )
+  {
+    assert( _size > 0 );
+    slot( 0 ).~T();
+    _head = (_head + 1) & _mask;
+    _size--;
+  }
+
+  void pop_back( void )
+  {
+    assert( _size > 0 );
+    slot( _size - 1 ).~T();
+    _size--;
+  }
+
+  T & at( const size_t i ) { assert( i < _size ); return slot( i ); }
+
+  T & front( void ) { return slot( 0 ); }
+  const T & front( void ) const { return slot( 0 ); }
+  T & back( void ) { return slot( _size - 1 ); }
+  const T & back( void ) const { return slot( _size - 1 ); }
+
+  size_t size( void ) const { return _size; }
+  bool empty( void ) const { return _size == 0; }
+
+  iterator begin( void ) { return iterator( this, 0 ); }
+  iterator end( void ) { return iterator( this, _size ); }
+  const_iterator begin( void ) const { return const_iterator( this, 0 ); }
+  const_iterator end( void ) const { return const_iterator( this, _size ); }
+};
+
+#endif
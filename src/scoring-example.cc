@@ -1,3 +1,4 @@
+#include <cmath>
 #include <cstdio>
 #include <vector>
 #include <string>
@@ -175,6 +176,11 @@ int main( int argc, char *argv[] )
 
   printf( "normalized_score = %f\n", norm_score );
 
+  for ( unsigned int i = 0; i < outcome.profiles.size(); i++ ) {
+    printf( "===\nprofile of config: %s\n%s", outcome.throughputs_delays.at( i ).first.str().c_str(),
+	    outcome.profiles.at( i ).str().c_str() );
+  }
+
   printf( "Whiskers: %s\n", outcome.used_actions.str().c_str() );
 
   return 0;
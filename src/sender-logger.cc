@@ -159,12 +159,16 @@ int main( int argc, char *argv[] )
 
   if ( is_poisson ) {
     SimulationResults<FinTree> results;
-    Fish example_sender = Fish( fins, global_PRNG()(), true );
+    const CompiledFinTree compiled_fins( fins );
+    UsageLedger usage( compiled_fins.num_leaves(), true );
+    Fish example_sender = Fish( compiled_fins, usage, global_PRNG()(), true );
     results = run_simulation_for_results<Fish, FinTree>( fins, config, example_sender, simulation_ticks, sender1_on_ticks, log_interval_ticks );
     serialize_to_file( results, datafilename );
   } else {
     SimulationResults<WhiskerTree> results;
-    Rat example_sender = Rat( whiskers, true );
+    const CompiledWhiskerTree compiled_whiskers( whiskers );
+    UsageLedger usage( compiled_whiskers.num_leaves(), true );
+    Rat example_sender = Rat( compiled_whiskers, usage, true );
     results = run_simulation_for_results<Rat, WhiskerTree>( whiskers, config, example_sender, simulation_ticks, sender1_on_ticks, log_interval_ticks );
     serialize_to_file( results, datafilename );
   }
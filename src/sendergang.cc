@@ -1,4 +1,8 @@
 #include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
 
 #include "sendergang.hh"
 
@@ -12,20 +16,42 @@ SenderGang<SenderType, SwitcherType>::SenderGang( const double mean_on_duration,
 						  PRNG & prng,
 						  const unsigned int id_range_begin )
   : _gang(),
+    _events( num_senders ),
+    _events_stale( false ),
+    _due(),
+    _sending(),
+    _sending_position( num_senders, -1 ),
+    _last_tick( 0 ),
+    _last_num_sending( 0 ),
     _prng( prng ),
     _start_distribution( 1.0 / mean_off_duration ),
     _stop_distribution( 1.0 / mean_on_duration )
 {
+  if ( uint64_t( id_range_begin ) + num_senders > Packet::max_senders ) {
+    fprintf( stderr, "Cannot simulate sender %lu: packets can only tell %u senders apart.\n",
+	     (unsigned long) id_range_begin + num_senders - 1, Packet::max_senders );
+    exit( 1 );
+  }
+
   for ( unsigned int i = 0; i < num_senders; i++ ) {
     _gang.emplace_back( i + id_range_begin,
 			_start_distribution.sample( _prng ),
 			exemplar );
   }
+
+  refresh_events( 0 );
 }
 
 template <class SenderType, class SwitcherType>
 SenderGang<SenderType, SwitcherType>::SenderGang()
   : _gang(),
+    _events(),
+    _events_stale( false ),
+    _due(),
+    _sending(),
+    _sending_position(),
+    _last_tick( 0 ),
+    _last_num_sending( 0 ),
     _prng( global_PRNG() ),
     _start_distribution( 1.0 ),
     _stop_distribution( 1.0 )
@@ -35,14 +61,110 @@ SenderGang<SenderType, SwitcherType>::SenderGang()
 template <class SenderType, class SwitcherType>
 void SenderGang<SenderType, SwitcherType>::switch_senders( const unsigned int num_sending, const double & tickno )
 {
-  /* let senders switch */
-  for ( auto &x : _gang ) {
-    x.switcher( tickno, _prng, _start_distribution, _stop_distribution, num_sending );
+  /* let senders switch (only those with an event due can have a
+     switch due; run_senders will visit them and refresh their times) */
+  collect_due( tickno );
+  for ( const auto & x : _due ) {
+    SwitcherType & sender = _gang[ x ];
+    const bool was_sending = sender.sending;
+
+    /* a sender switching off first settles what it's owed */
+    sender.settle( _last_tick, _last_num_sending );
+    sender.switcher( tickno, _prng, _start_distribution, _stop_distribution, num_sending );
+
+    if ( sender.sending != was_sending ) {
+      note_switch( x );
+    }
+  }
+
+  if ( _events_stale ) {
+    list_sending();
   }
 }
 
+template <class SenderType, class SwitcherType>
+void SenderGang<SenderType, SwitcherType>::settle_all( void )
+{
+  if ( _events_stale ) {
+    /* a sender may have been switched from outside the gang */
+    for ( auto & x : _gang ) {
+      x.settle( _last_tick, _last_num_sending );
+    }
+    return;
+  }
+
+  for ( const auto & x : _sending ) {
+    _gang[ x ].settle( _last_tick, _last_num_sending );
+  }
+}
+
+template <class SenderType, class SwitcherType>
+void SenderGang<SenderType, SwitcherType>::note_switch( const unsigned int i )
+{
+  if ( _events_stale ) {
+    return; /* list_sending will start over */
+  }
+
+  if ( _gang[ i ].sending ) {
+    _sending_position[ i ] = _sending.size();
+    _sending.push_back( i );
+  } else {
+    /* move the last in the list into its place */
+    const unsigned int last = _sending.back();
+    _sending[ _sending_position[ i ] ] = last;
+    _sending_position[ last ] = _sending_position[ i ];
+    _sending.pop_back();
+    _sending_position[ i ] = -1;
+  }
+}
+
+template <class SenderType, class SwitcherType>
+void SenderGang<SenderType, SwitcherType>::list_sending( void )
+{
+  _sending.clear();
+  for ( unsigned int i = 0; i < _gang.size(); i++ ) {
+    _sending_position[ i ] = -1;
+    if ( _gang[ i ].sending ) {
+      _sending_position[ i ] = _sending.size();
+      _sending.push_back( i );
+    }
+  }
+}
+
+template <class SenderType, class SwitcherType>
+void SenderGang<SenderType, SwitcherType>::collect_due( const double & tickno )
+{
+  _due.clear();
+
+  if ( _events_stale ) {
+    /* a sender was modified from outside the gang, so visit them all */
+    for ( unsigned int i = 0; i < _gang.size(); i++ ) {
+      _due.push_back( i );
+    }
+    return;
+  }
+
+  _events.due( tickno, _due );
+}
+
+template <class SenderType, class SwitcherType>
+void SenderGang<SenderType, SwitcherType>::refresh_events( const double & tickno )
+{
+  for ( unsigned int i = 0; i < _gang.size(); i++ ) {
+    _events.update( i, _gang[ i ].next_event_time( tickno ) );
+  }
+
+  _events_stale = false;
+}
+
 template <class SenderType, class SwitcherType>
 unsigned int SenderGang<SenderType, SwitcherType>::count_active_senders( void ) const
+{
+  return _events_stale ? recount_active_senders() : _sending.size();
+}
+
+template <class SenderType, class SwitcherType>
+unsigned int SenderGang<SenderType, SwitcherType>::recount_active_senders( void ) const
 {
   return accumulate( _gang.begin(), _gang.end(),
 		     0, []( const unsigned int a, const SwitchedSender<SenderType> & b )
@@ -68,18 +190,54 @@ void SenderGang<SenderType, SwitcherType>::run_senders( NextHop & next, Receiver
 							const unsigned int num_sending,
 							const double & tickno )
 {
-  /* run senders in random order */
-  vector<unsigned int> sender_indices;
-  sender_indices.reserve( _gang.size() );
-  for ( unsigned int i = 0; i < _gang.size(); i++ ) {
-    sender_indices.emplace_back( i );
+  /* Visit the senders that have something to do this tick -- an
+     event due (a send or a switch) or ACKs waiting at the receiver --
+     in uniformly random order. Any other sender's tick would only
+     have counted its sending time, which is settled lazily, so the
+     random order among the senders that act is the same as if every
+     sender had been shuffled and visited, as before. */
+  collect_due( tickno );
+
+  if ( not _events_stale and not _gang.empty() ) {
+    const unsigned int first_id = id_of_first_sender();
+    rec.for_each_readable( first_id, first_id + _gang.size(),
+			   [&] ( const unsigned int src ) {
+			     const unsigned int i = src - first_id;
+			     if ( _events.event_time( i ) > tickno ) {
+			       _due.push_back( i ); /* not already due */
+			     }
+			   } );
   }
 
   /* Fisher-Yates shuffle */
-  shuffle( sender_indices.begin(), sender_indices.end(), _prng );
+  shuffle( _due.begin(), _due.end(), _prng.get() );
 
-  for ( auto &x : sender_indices ) {
-    _gang[ x ].tick( next, rec, tickno, num_sending, _prng, _start_distribution );
+  /* senders not visited owe nothing more until the share changes */
+  if ( num_sending != _last_num_sending ) {
+    settle_all();
+  }
+  _last_tick = tickno;
+  _last_num_sending = num_sending;
+
+  for ( const auto & x : _due ) {
+    SwitcherType & sender = _gang[ x ];
+    const bool was_sending = sender.sending;
+
+    sender.tick( next, rec, tickno, num_sending, _prng, _start_distribution );
+
+    if ( sender.sending != was_sending ) {
+      note_switch( x );
+    }
+  }
+
+  if ( _events_stale ) {
+    list_sending();
+    refresh_events( tickno );
+  } else {
+    /* no other sender's next event can have moved */
+    for ( const auto & x : _due ) {
+      _events.update( x, _gang[ x ].next_event_time( tickno ) );
+    }
   }
 }
 
@@ -167,7 +325,7 @@ template <class SenderType>
 void SwitchedSender<SenderType>::receive_feedback( Receiver & rec )
 {
   if ( rec.readable( id ) ) {
-    const std::vector< Packet > & packets = rec.packets_for( id );
+    const PacketSpan packets = rec.packets_for( id );
 
     utility.packets_received( packets );
     sender.packets_received( packets );
@@ -243,7 +401,7 @@ double SenderGang<SenderType, SwitcherType>::utility( void ) const
   if ( _gang.empty() ) return 0.0;
 
   for ( auto &x : _gang ) {
-    total_utility += x.utility.utility();
+    total_utility += x.utility_at( _last_tick, _last_num_sending ).utility();
   }
 
   return total_utility / _gang.size(); /* mean utility per sender */
@@ -256,17 +414,29 @@ vector< pair< double, double > > SenderGang<SenderType, SwitcherType>::throughpu
   ret.reserve( _gang.size() );
 
   for ( auto &x : _gang ) {
-    ret.emplace_back( x.utility.average_throughput_normalized_to_equal_share(),
-		      x.utility.average_delay() );
+    const Utility utility = x.utility_at( _last_tick, _last_num_sending );
+    ret.emplace_back( utility.average_throughput_normalized_to_equal_share(),
+		      utility.average_delay() );
   }
 
   return ret;
 }
 
 template <class SenderType>
-SenderDataPoint SwitchedSender<SenderType>::statistics_for_log( void ) const
+Utility SwitchedSender<SenderType>::utility_at( const double & tickno, const unsigned int num_sending ) const
 {
-  return SenderDataPoint( sender.state_DNA(), utility.DNA(), sending );
+  Utility ret( utility );
+  if ( sending and tickno > internal_tick ) {
+    ret.sending_duration( tickno - internal_tick, num_sending );
+  }
+  return ret;
+}
+
+template <class SenderType>
+SenderDataPoint SwitchedSender<SenderType>::statistics_for_log( const double & tickno,
+								const unsigned int num_sending ) const
+{
+  return SenderDataPoint( sender.state_DNA(), utility_at( tickno, num_sending ).DNA(), sending );
 }
 
 template <class SenderType, class SwitcherType>
@@ -275,7 +445,7 @@ vector< SenderDataPoint > SenderGang<SenderType, SwitcherType>::statistics_for_l
   vector < SenderDataPoint > points;
   points.reserve( _gang.size() );
   for ( auto &x : _gang ) {
-    points.push_back( x.statistics_for_log() );
+    points.push_back( x.statistics_for_log( _last_tick, _last_num_sending ) );
   }
   return points;
 }
@@ -291,14 +461,20 @@ double SwitchedSender<SenderType>::next_event_time( const double & tickno ) cons
 template <class SenderType, class SwitcherType>
 double SenderGang<SenderType, SwitcherType>::next_event_time( const double & tickno ) const
 {
-  double ret = std::numeric_limits<double>::max();
-  for ( const auto & x : _gang ) {
-    const double the_next_event = x.next_event_time( tickno );
-    assert( the_next_event >= tickno );
-    if ( the_next_event < ret ) {
-      ret = the_next_event;
+  if ( _events_stale ) {
+    /* a sender was modified from outside the gang, so fall back to asking each one */
+    double ret = std::numeric_limits<double>::max();
+    for ( const auto & x : _gang ) {
+      const double the_next_event = x.next_event_time( tickno );
+      assert( the_next_event >= tickno );
+      if ( the_next_event < ret ) {
+	ret = the_next_event;
+      }
     }
+
+    return ret;
   }
 
-  return ret;
+  /* a sender that was ready to send when its time was recorded is still ready now */
+  return max( _events.next_event_time(), tickno );
 }
@@ -1,8 +1,11 @@
 #ifndef SENDERGANG_HH
 #define SENDERGANG_HH
 
+#include <functional>
+#include <type_traits>
 #include <vector>
 
+#include "eventqueue.hh"
 #include "exponential.hh"
 #include "receiver.hh"
 #include "utility.hh"
@@ -11,19 +14,19 @@
 template <class SenderType>
 class SwitchedSender {
 private:
+  /* what settle() looks at comes first, on one cache line, so that
+     SenderGang::settle_all touches one line per sender */
   double internal_tick;
 
+public:
+  Utility utility;
+  bool sending;
+  unsigned int id;
+
 protected:
   double next_switch_tick;
   SenderType sender;
 
-  /* is abstract base class */
-  virtual void switcher( const double & tickno,
-			 PRNG & prng,
-			 Exponential & start_distribution,
-			 Exponential & stop_distribution,
-			 const unsigned int num_sending ) = 0;
-
   void accumulate_sending_time_until( const double & tickno, const unsigned int num_sending );
 
   void receive_feedback( Receiver & rec );
@@ -32,26 +35,47 @@ public:
   void switch_on( const double & tickno );
   void switch_off( const double & tickno, const unsigned int num_sending );
 
+  /* count sending time not yet accumulated, up to tickno, as shared
+     among num_sending senders throughout */
+  void settle( const double & tickno, const unsigned int num_sending )
+  {
+    if ( sending and tickno > internal_tick ) {
+      accumulate_sending_time_until( tickno, num_sending );
+    }
+  }
+
+  template <typename... Args>
+  void rebind( Args &... args ) { sender.rebind( args... ); }
+
+  /* utility as if settle( tickno, num_sending ) had been called */
+  Utility utility_at( const double & tickno, const unsigned int num_sending ) const;
+
   double next_event_time( const double & tickno ) const;
-  SenderDataPoint statistics_for_log( void ) const;
-  Utility utility;
-  bool sending;
-  unsigned int id;
+  SenderDataPoint statistics_for_log( const double & tickno, const unsigned int num_sending ) const;
 
   SwitchedSender( const unsigned int s_id,
 		  const double & start_tick,
 		  const SenderType & s_sender )
     : internal_tick( 0 ),
-      next_switch_tick( start_tick ),
-      sender( s_sender ),
       utility(),
       sending( false ),
-      id( s_id )
+      id( s_id ),
+      next_switch_tick( start_tick ),
+      sender( s_sender )
   {}
 
-  virtual ~SwitchedSender() {}
+protected:
+  /* only the kinds of switching below are senders */
+  ~SwitchedSender() {}
 };
 
+/* Each kind of switching supplies its own tick() and
+
+     void switcher( tickno, prng, start_distribution, stop_distribution, num_sending );
+
+   SenderGang is given the kind as a template parameter and calls them
+   directly, so they can be inlined and senders carry no vtable. */
+
 template <class SenderType>
 class TimeSwitchedSender : public SwitchedSender<SenderType> {
 public:
@@ -66,7 +90,7 @@ public:
 		 PRNG & prng,
 		 Exponential & start_distribution,
 		 Exponential & stop_distribution,
-		 const unsigned int num_sending ) override;
+		 const unsigned int num_sending );
 
   using SwitchedSender<SenderType>::SwitchedSender;
 };
@@ -88,7 +112,7 @@ public:
 		 PRNG & prng,
 		 Exponential & start_distribution,
 		 Exponential & stop_distribution,
-		 const unsigned int num_sending ) override;
+		 const unsigned int num_sending );
 
   using SwitchedSender<SenderType>::SwitchedSender;
 };
@@ -107,7 +131,7 @@ public:
 		 PRNG &,
 		 Exponential &,
 		 Exponential &,
-		 const unsigned int ) override
+		 const unsigned int )
   {
     SwitchedSender<SenderType>::next_switch_tick = std::numeric_limits<double>::max();
   } /* don't switch */
@@ -119,12 +143,44 @@ template <class SenderType, class SwitcherType>
 class SenderGang
 {
 private:
+  static_assert( std::is_base_of< SwitchedSender< SenderType >, SwitcherType >::value,
+		 "a gang's senders are SwitchedSenders" );
+
   std::vector< SwitcherType > _gang;
 
-  PRNG & _prng;
+  /* next event time of each sender. A tick updates only the entries
+     of the senders it visited, at O(log n) each; every entry is
+     refreshed only when the gang starts and after mutable_sender(). */
+  EventQueue _events;
+  bool _events_stale;
+
+  /* senders to visit this tick (reused from tick to tick) */
+  std::vector< unsigned int > _due;
+
+  /* the senders that are sending, in no order, and each sender's
+     place in that list (or -1), so that settling them all doesn't
+     have to look at the rest; rebuilt when _events_stale is cleared */
+  std::vector< unsigned int > _sending;
+  std::vector< int > _sending_position;
+
+  /* Sending time is only accumulated when a sender is visited or the
+     number sending changes; until then each sending sender is owed the
+     time since its last visit up to _last_tick, shared among
+     _last_num_sending senders. */
+  double _last_tick;
+  unsigned int _last_num_sending;
+
+  std::reference_wrapper< PRNG > _prng;
 
   Exponential _start_distribution, _stop_distribution;
 
+  void refresh_events( const double & tickno );
+  void collect_due( const double & tickno );
+  void settle_all( void );
+  void note_switch( const unsigned int i );
+  void list_sending( void );
+  unsigned int recount_active_senders( void ) const;
+
 public:
   typedef SenderType Sender;
 
@@ -159,7 +215,26 @@ public:
 
   double next_event_time( const double & tickno ) const;
 
-  SwitcherType & mutable_sender( const unsigned int num ) { return _gang.at( num ); }
+  /* bytes held on the heap */
+  size_t footprint( void ) const
+  {
+    return _gang.capacity() * sizeof( SwitcherType ) + _events.footprint()
+      + (_due.capacity() + _sending.capacity()) * sizeof( unsigned int )
+      + _sending_position.capacity() * sizeof( int );
+  }
+
+  /* draw from prng, and have every sender use the given rules and
+     ledger, from now on (for a copy that has to outlive the originals) */
+  template <typename... Args>
+  void rebind( PRNG & prng, Args &... args )
+  {
+    _prng = std::ref( prng );
+    for ( auto & x : _gang ) {
+      x.rebind( args... );
+    }
+  }
+
+  SwitcherType & mutable_sender( const unsigned int num ) { settle_all(); _events_stale = true; return _gang.at( num ); }
   const SwitcherType & sender( const unsigned int num ) const { return _gang.at( num ); }
 };
 
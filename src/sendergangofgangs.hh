@@ -4,6 +4,7 @@
 #include <vector>
 #include <utility>
 #include "receiver.hh"
+#include "random.hh"
 #include "senderdatapoint.hh"
 
 template <class Gang1Type, class Gang2Type>
@@ -41,6 +42,11 @@ public:
   const Gang1Type & gang1( void ) const { return gang1_; }
   const Gang2Type & gang2( void ) const { return gang2_; }
 
+  template <typename... Args>
+  void rebind( PRNG & prng, Args &... args ) { gang1_.rebind( prng, args... ); gang2_.rebind( prng, args... ); }
+
+  size_t footprint( void ) const { return gang1_.footprint() + gang2_.footprint(); }
+
   Gang1Type & mutable_gang1( void ) { return gang1_; }
   Gang2Type & mutable_gang2( void ) { return gang2_; }
 };
@@ -2,21 +2,44 @@
 #define STOCHASTICLOSS_HH
 
 #include "packet.hh"
-#include <deque>
 #include <tuple>
-#include <random>
+#include <functional>
 #include "exponential.hh"
+#include "ringbuffer.hh"
 
 class StochasticLoss
 {
   private:
-    std::deque< std::tuple< double, Packet > > _buffer;
+    RingBuffer< std::tuple< double, Packet > > _buffer;
     double _loss_rate;
-    PRNG & _prng;
-    std::bernoulli_distribution _distr;
+    std::reference_wrapper< PRNG > _prng;
+
+    /* upcoming drop decisions, a batch of 64 at a time */
+    uint64_t _drops;
+    unsigned int _drops_left;
+
+    bool drop( void )
+    {
+      if ( _loss_rate <= 0 ) {
+        return false;
+      }
+
+      if ( _drops_left == 0 ) {
+        _drops = bernoulli_bits( _prng, _loss_rate );
+        _drops_left = 64;
+      }
+
+      const bool ret = _drops & 1;
+      _drops >>= 1;
+      _drops_left--;
+      return ret;
+    }
 
   public:
-    StochasticLoss( const double & rate, PRNG &prng ) :  _buffer(), _loss_rate( rate ), _prng( prng ), _distr() { _distr = std::bernoulli_distribution( rate );}
+    StochasticLoss( const double & rate, PRNG &prng ) :  _buffer(), _loss_rate( rate ), _prng( prng ), _drops( 0 ), _drops_left( 0 ) {}
+    void rebind( PRNG & prng ) { _prng = std::ref( prng ); }
+    size_t footprint( void ) const { return _buffer.footprint(); }
+
     template <class NextHop>
     void tick( NextHop & next, const double & tickno )
     {
@@ -28,7 +51,7 @@ class StochasticLoss
     }
     void accept( const Packet & p, const double & tickno ) noexcept
     {
-      if (!(_distr( _prng ))) {
+      if ( not drop() ) {
         _buffer.emplace_back( tickno, p );
       }
     }
@@ -0,0 +1,169 @@
+#include <cassert>
+#include <random>
+
+#include "threadpool.hh"
+
+using namespace std;
+
+static thread_local const ThreadPool * current_pool = nullptr;
+static thread_local unsigned int current_index = 0;
+static thread_local minstd_rand shuffle_prng;
+
+ThreadPool::ThreadPool( const unsigned int num_threads, const unsigned int shuffle_seed )
+  : _queues(),
+    _workers(),
+    _sleep_mutex(),
+    _wakeup(),
+    _queued( 0 ),
+    _next_queue( 0 ),
+    _stopping( false ),
+    _shuffle_seed( shuffle_seed )
+{
+  assert( num_threads > 0 );
+
+  for ( unsigned int i = 0; i < num_threads; i++ ) {
+    _queues.emplace_back( new TaskQueue );
+  }
+
+  for ( unsigned int i = 0; i < num_threads; i++ ) {
+    _workers.emplace_back( [this, i] () { worker_loop( i ); } );
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    unique_lock< mutex > lock( _sleep_mutex );
+    _stopping = true;
+  }
+  _wakeup.notify_all();
+
+  for ( auto & x : _workers ) {
+    x.join();
+  }
+}
+
+bool ThreadPool::in_worker( void ) const
+{
+  return current_pool == this;
+}
+
+void ThreadPool::push( function< void( void ) > && task )
+{
+  /* workers keep their own subtasks local; other threads spread work round-robin */
+  unsigned int index = in_worker() ? current_index : _next_queue++ % _queues.size();
+  if ( _shuffle_seed ) {
+    index = shuffle_prng() % _queues.size();
+  }
+
+  /* count the task before publishing it, so a pop() can never take
+     _queued below zero; a sleeper woken in between just retries */
+  {
+    unique_lock< mutex > lock( _sleep_mutex );
+    _queued++;
+  }
+
+  {
+    unique_lock< mutex > lock( _queues[ index ]->mutex );
+    _queues[ index ]->tasks.push_back( move( task ) );
+  }
+
+  _wakeup.notify_one();
+}
+
+bool ThreadPool::pop( function< void( void ) > & task )
+{
+  const bool local = in_worker() and not _shuffle_seed;
+  const unsigned int first = _shuffle_seed ? shuffle_prng() % _queues.size()
+    : local ? current_index : 0;
+
+  for ( unsigned int i = 0; i < _queues.size(); i++ ) {
+    TaskQueue & queue = *_queues[ (first + i) % _queues.size() ];
+    unique_lock< mutex > lock( queue.mutex );
+    if ( queue.tasks.empty() ) {
+      continue;
+    }
+
+    if ( _shuffle_seed ? shuffle_prng() % 2 : (local and i == 0) ) {
+      /* own queue: newest task first */
+      task = move( queue.tasks.back() );
+      queue.tasks.pop_back();
+    } else {
+      /* steal the oldest task */
+      task = move( queue.tasks.front() );
+      queue.tasks.pop_front();
+    }
+
+    _queued--;
+    return true;
+  }
+
+  return false;
+}
+
+bool ThreadPool::run_pending_task( void )
+{
+  function< void( void ) > task;
+  if ( not pop( task ) ) {
+    return false;
+  }
+
+  if ( _shuffle_seed ) {
+    this_thread::sleep_for( chrono::microseconds( shuffle_prng() % 1000 ) );
+  }
+
+  task();
+
+  /* wake anyone in get() waiting on the result this task may have set */
+  notify_waiters();
+
+  return true;
+}
+
+void ThreadPool::notify_waiters( void )
+{
+  {
+    unique_lock< mutex > lock( _sleep_mutex );
+  }
+  _wakeup.notify_all();
+}
+
+void ThreadPool::worker_loop( const unsigned int index )
+{
+  current_pool = this;
+  current_index = index;
+  shuffle_prng.seed( _shuffle_seed + index );
+
+  while ( true ) {
+    if ( run_pending_task() ) {
+      continue;
+    }
+
+    unique_lock< mutex > lock( _sleep_mutex );
+    _wakeup.wait( lock, [this] () { return _stopping or _queued > 0; } );
+    if ( _stopping and _queued == 0 ) {
+      return;
+    }
+  }
+}
+
+static unsigned int global_thread_pool_size = 0;
+static unsigned int global_thread_pool_shuffle_seed = 0;
+
+void set_global_thread_pool_size( const unsigned int num_threads )
+{
+  global_thread_pool_size = num_threads;
+}
+
+void set_global_thread_pool_shuffle_seed( const unsigned int shuffle_seed )
+{
+  global_thread_pool_shuffle_seed = shuffle_seed;
+}
+
+ThreadPool & global_thread_pool( void )
+{
+  static ThreadPool pool( global_thread_pool_size ? global_thread_pool_size
+			  : max( 1u, thread::hardware_concurrency() ),
+			  global_thread_pool_shuffle_seed );
+  return pool;
+}
@@ -0,0 +1,116 @@
+#ifndef THREADPOOL_HH
+#define THREADPOOL_HH
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/* Fixed-size work-stealing executor. Each worker owns a queue of tasks
+   (newest first); idle workers steal the oldest task from the others.
+   A worker that waits on a result runs queued tasks instead of blocking,
+   so tasks may themselves submit and wait on further tasks. Waiters are
+   woken when a task finishes, or by notify_waiters(). */
+class ThreadPool
+{
+private:
+  struct TaskQueue
+  {
+    std::mutex mutex {};
+    std::deque< std::function< void( void ) > > tasks {};
+  };
+
+  std::vector< std::unique_ptr< TaskQueue > > _queues;
+  std::vector< std::thread > _workers;
+
+  std::mutex _sleep_mutex;
+  std::condition_variable _wakeup;
+  std::atomic< unsigned int > _queued;
+  std::atomic< unsigned int > _next_queue;
+  bool _stopping;
+
+  const unsigned int _shuffle_seed;
+
+  void push( std::function< void( void ) > && task );
+  bool pop( std::function< void( void ) > & task );
+  void worker_loop( const unsigned int index );
+
+public:
+  /* a nonzero shuffle_seed puts tasks on random queues, takes them in
+     random order and delays each by a random moment, to check that
+     results don't depend on how the work is scheduled */
+  explicit ThreadPool( const unsigned int num_threads, const unsigned int shuffle_seed = 0 );
+  ~ThreadPool();
+
+  ThreadPool( const ThreadPool & ) = delete;
+  ThreadPool & operator=( const ThreadPool & ) = delete;
+
+  unsigned int size( void ) const { return _workers.size(); }
+
+  /* is the calling thread one of this pool's workers? */
+  bool in_worker( void ) const;
+
+  template <typename F>
+  std::future< typename std::result_of< F() >::type > submit( F && f );
+
+  /* run one queued task on the calling thread, if there is one */
+  bool run_pending_task( void );
+
+  /* wait for a result, helping with queued work if called from a worker */
+  template <typename R>
+  R get( std::future< R > & result );
+
+  /* wake the workers waiting in get(), after setting a result that
+     wasn't produced by one of this pool's tasks */
+  void notify_waiters( void );
+};
+
+/* must be called before the first use of global_thread_pool() */
+extern void set_global_thread_pool_size( const unsigned int num_threads );
+extern void set_global_thread_pool_shuffle_seed( const unsigned int shuffle_seed );
+
+extern ThreadPool & global_thread_pool( void );
+
+template <typename F>
+std::future< typename std::result_of< F() >::type > ThreadPool::submit( F && f )
+{
+  typedef typename std::result_of< F() >::type R;
+
+  auto task = std::make_shared< std::packaged_task< R() > >( std::forward< F >( f ) );
+  std::future< R > ret = task->get_future();
+
+  push( [task] () { (*task)(); } );
+
+  return ret;
+}
+
+template <typename R>
+R ThreadPool::get( std::future< R > & result )
+{
+  if ( in_worker() ) {
+    auto ready = [&result] () {
+      return result.wait_for( std::chrono::seconds( 0 ) ) == std::future_status::ready;
+    };
+
+    while ( not ready() ) {
+      if ( run_pending_task() ) {
+	continue;
+      }
+
+      /* sleep until there is work to help with or some task finishes */
+      std::unique_lock< std::mutex > lock( _sleep_mutex );
+      _wakeup.wait( lock, [this, &ready] () { return _queued > 0 or ready(); } );
+    }
+  }
+
+  return result.get();
+}
+
+#endif
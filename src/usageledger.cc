@@ -0,0 +1,74 @@
+#include <cassert>
+
+#include "usageledger.hh"
+
+using namespace std;
+
+UsageLedger::UsageLedger( const unsigned int num_leaves, const bool track )
+  : _counts( num_leaves ),
+    _tracking( track ),
+    _medians( track ? num_leaves : 0 )
+{
+}
+
+void UsageLedger::track( const unsigned int leaf, const Memory & query, const vector< Axis > & active_axis )
+{
+  assert( tracking() );
+
+  vector< MedianSketch > & medians = _medians[ leaf ];
+  if ( medians.empty() ) {
+    medians.resize( active_axis.size() );
+  }
+
+  for ( unsigned int i = 0; i < active_axis.size(); i++ ) {
+    medians[ i ].add( query.field( active_axis[ i ] ) );
+  }
+}
+
+void UsageLedger::merge( const UsageLedger & other )
+{
+  assert( other.num_leaves() == num_leaves() );
+  assert( other.tracking() == tracking() );
+
+  for ( unsigned int i = 0; i < _counts.size(); i++ ) {
+    _counts[ i ] += other._counts[ i ];
+  }
+
+  if ( not tracking() ) {
+    return;
+  }
+
+  for ( unsigned int i = 0; i < _medians.size(); i++ ) {
+    const vector< MedianSketch > & theirs = other._medians[ i ];
+    vector< MedianSketch > & ours = _medians[ i ];
+
+    if ( ours.empty() ) {
+      ours = theirs;
+      continue;
+    }
+
+    assert( theirs.empty() or theirs.size() == ours.size() );
+    for ( unsigned int j = 0; j < theirs.size(); j++ ) {
+      ours[ j ].merge( theirs[ j ] );
+    }
+  }
+}
+
+uint64_t UsageLedger::total_uses( void ) const
+{
+  uint64_t ret = 0;
+  for ( const auto & x : _counts ) {
+    ret += x;
+  }
+  return ret;
+}
+
+size_t UsageLedger::footprint( void ) const
+{
+  size_t ret = _counts.capacity() * sizeof( unsigned int )
+    + _medians.capacity() * sizeof( vector< MedianSketch > );
+  for ( const auto & x : _medians ) {
+    ret += x.capacity() * sizeof( MedianSketch );
+  }
+  return ret;
+}
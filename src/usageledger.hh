@@ -0,0 +1,39 @@
+#ifndef USAGELEDGER_HH
+#define USAGELEDGER_HH
+
+#include <vector>
+
+#include "memoryrange.hh"
+
+/* Record of how often each leaf of a rule tree was used during an
+   evaluation, and (when tracking) of the queries that reached it.
+   Leaves are numbered in depth-first order. Keeping this outside the
+   tree lets every simulation share one read-only copy of the rules.
+   Ledgers from separate simulations can be merged, medians included. */
+class UsageLedger
+{
+private:
+  std::vector< unsigned int > _counts;
+  bool _tracking;
+  std::vector< std::vector< MedianSketch > > _medians; /* per leaf, one per active axis */
+
+public:
+  UsageLedger( const unsigned int num_leaves, const bool track );
+
+  void use( const unsigned int leaf ) { _counts[ leaf ]++; }
+  void track( const unsigned int leaf, const Memory & query, const std::vector< Axis > & active_axis );
+
+  /* add another ledger's counts (and medians) to this one */
+  void merge( const UsageLedger & other );
+
+  bool tracking( void ) const { return _tracking; }
+  unsigned int num_leaves( void ) const { return _counts.size(); }
+  unsigned int count( const unsigned int leaf ) const { return _counts[ leaf ]; }
+  uint64_t total_uses( void ) const;
+  const std::vector< MedianSketch > & medians( const unsigned int leaf ) const { return _medians[ leaf ]; }
+
+  /* bytes held on the heap */
+  size_t footprint( void ) const;
+};
+
+#endif
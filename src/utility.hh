@@ -4,6 +4,7 @@
 #include <cmath>
 #include <cassert>
 #include <climits>
+#include "packet.hh"
 #include "simulationresults.pb.h"
 
 class Utility
@@ -17,7 +18,7 @@ public:
   Utility( void ) : _tick_share_sending( 0 ), _packets_received( 0 ), _total_delay( 0 ) {}
 
   void sending_duration( const double & duration, const unsigned int num_sending ) { _tick_share_sending += duration / double( num_sending ); }
-  void packets_received( const std::vector< Packet > & packets ) {
+  void packets_received( const PacketSpan & packets ) {
     _packets_received += packets.size();
 
     for ( auto &x : packets ) {
@@ -28,57 +28,29 @@ WhiskerTree::WhiskerTree( const Whisker & whisker, const bool bisect )
   }
 }
 
-void WhiskerTree::reset_counts( void )
+void WhiskerTree::apply_usage( const UsageLedger & usage )
 {
-  if ( is_leaf() ) {
-    _leaf.front().reset_count();
-  } else {
-    for ( auto &x : _children ) {
-      x.reset_counts();
-    }
-  }
+  const unsigned int num_leaves __attribute((unused)) = apply_usage( usage, 0 );
+  assert( num_leaves == usage.num_leaves() );
 }
 
-const Whisker & WhiskerTree::use_whisker( const Memory & _memory, const bool track ) const
+unsigned int WhiskerTree::apply_usage( const UsageLedger & usage, const unsigned int first_leaf )
 {
-  const Whisker * ret( whisker( _memory ) );
-
-  if ( !ret ) {
-    fprintf( stderr, "ERROR: No whisker found for %s\n", _memory.str().c_str() );
-    exit( 1 );
-  }
-
-  assert( ret );
-
-  ret->use();
-
-  if ( track ) {
-    ret->domain().track( _memory );
-  }
-
-  return *ret;
-}
-
-const Whisker * WhiskerTree::whisker( const Memory & _memory ) const
-{
-  if ( !_domain.contains( _memory ) ) {
-    return nullptr;
-  }
-
   if ( is_leaf() ) {
-    return &_leaf[ 0 ];
+    _leaf.front().set_count( usage.count( first_leaf ) );
+    if ( usage.tracking() ) {
+      _leaf.front().set_medians( usage.medians( first_leaf ) );
+    }
+    return first_leaf + 1;
   }
 
-  /* need to descend */
+  /* number leaves depth-first, like CompiledTree */
+  unsigned int next_leaf = first_leaf;
   for ( auto &x : _children ) {
-    auto ret( x.whisker( _memory ) );
-    if ( ret ) {
-      return ret;
-    }
+    next_leaf = x.apply_usage( usage, next_leaf );
   }
 
-  assert( false );
-  return nullptr;
+  return next_leaf;
 }
 
 const Whisker * WhiskerTree::most_used( const unsigned int max_generation ) const
@@ -6,6 +6,7 @@
 #include "configrange.hh"
 #include "whisker.hh"
 #include "memoryrange.hh"
+#include "usageledger.hh"
 #include "dna.pb.h"
 
 class WhiskerTree {
@@ -15,22 +16,25 @@ private:
   std::vector< WhiskerTree > _children;
   std::vector< Whisker > _leaf;
 
-  const Whisker * whisker( const Memory & _memory ) const;
+  unsigned int apply_usage( const UsageLedger & usage, const unsigned int first_leaf );
+
+  template <class TreeType, class ActionType> friend class CompiledTree;
 
 public:
+  typedef Whisker ActionType;
+
   WhiskerTree();
 
   WhiskerTree( const Whisker & whisker, const bool bisect );
 
-  const Whisker & use_whisker( const Memory & _memory, const bool track ) const;
-
   void use_window( const unsigned int win ) const;
 
   bool replace( const Whisker & w );
   bool replace( const Whisker & src, const WhiskerTree & dst );
   const Whisker * most_used( const unsigned int max_generation ) const;
 
-  void reset_counts( void );
+  /* set usage counts (and medians, if tracked) from an evaluation of this tree */
+  void apply_usage( const UsageLedger & usage );
   void promote( const unsigned int generation );
   void reset_generation( void );
 